@@ -0,0 +1,91 @@
+//*****************************************************************************
+//
+// Crystalfontz128x128_Buffer.c - Off-screen pixel buffers for the Crystalfontz
+//                                128x128 display driver.
+//
+//*****************************************************************************
+
+#include "Crystalfontz128x128_Buffer.h"
+#include "Crystalfontz128x128_ST7735.h"
+#include <stdint.h>
+#include <string.h>
+
+//*****************************************************************************
+//
+//! Fills a rectangle in a buffer.
+//!
+//! \param psBuffer is the buffer to draw into.
+//! \param x0, y0, x1, y1 are the inclusive screen coordinates of the
+//! rectangle.
+//! \param ulValue is the color, as returned by the driver's ColorTranslate.
+//!
+//! The rectangle is clipped to the rows held by the buffer; the columns are
+//! assumed to be within the extents of the display.
+//!
+//! \return None.
+//
+//*****************************************************************************
+void Crystalfontz128x128_BufferFill(const Crystalfontz128x128_Buffer *psBuffer,
+                                    int16_t x0, int16_t y0,
+                                    int16_t x1, int16_t y1,
+                                    uint16_t ulValue)
+{
+    uint16_t usWire = (ulValue >> 8) | (ulValue << 8);
+    uint16_t *pusRow;
+    int16_t y, x;
+
+    if (y0 < psBuffer->sYOrigin)
+        y0 = psBuffer->sYOrigin;
+    if (y1 > psBuffer->sYOrigin + psBuffer->sRows - 1)
+        y1 = psBuffer->sYOrigin + psBuffer->sRows - 1;
+
+    pusRow = psBuffer->pusPixels +
+             (y0 - psBuffer->sYOrigin) * LCD_HORIZONTAL_MAX;
+    for (y = y0; y <= y1; y++)
+    {
+        for (x = x0; x <= x1; x++)
+            pusRow[x] = usWire;
+        pusRow += LCD_HORIZONTAL_MAX;
+    }
+}
+
+
+//*****************************************************************************
+//
+//! Copies a run of pixels, already in the panel's byte order, into a buffer.
+//!
+//! \param psBuffer is the buffer to draw into.
+//! \param x, y are the screen coordinates of the first pixel.
+//! \param pucData points to the pixels.
+//! \param usBytes is the length of the run in bytes.
+//!
+//! Rows that are not held by the buffer are ignored.
+//!
+//! \return None.
+//
+//*****************************************************************************
+void Crystalfontz128x128_BufferWrite(const Crystalfontz128x128_Buffer *psBuffer,
+                                     int16_t x, int16_t y,
+                                     const uint8_t *pucData,
+                                     uint16_t usBytes)
+{
+    if ((y < psBuffer->sYOrigin) ||
+        (y >= psBuffer->sYOrigin + psBuffer->sRows))
+        return;
+
+    memcpy(psBuffer->pusPixels + (y - psBuffer->sYOrigin) * LCD_HORIZONTAL_MAX + x,
+           pucData, usBytes);
+}
+
+
+//*****************************************************************************
+//
+//! Returns the address of a pixel in a buffer, for sending it to the panel.
+//
+//*****************************************************************************
+const uint8_t *Crystalfontz128x128_BufferRow(const Crystalfontz128x128_Buffer *psBuffer,
+                                             int16_t x, int16_t y)
+{
+    return (const uint8_t *)(psBuffer->pusPixels +
+                             (y - psBuffer->sYOrigin) * LCD_HORIZONTAL_MAX + x);
+}
@@ -0,0 +1,40 @@
+//*****************************************************************************
+//
+// Crystalfontz128x128_Buffer.h - Off-screen pixel buffers for the Crystalfontz
+//                                128x128 display driver.
+//
+// A buffer holds a horizontal band of full-width screen rows.  Pixels are
+// stored in the panel's byte order (RGB565, most significant byte first), so
+// a run of pixels can be handed to the SPI or DMA without conversion.
+//
+//*****************************************************************************
+
+#ifndef __CRYSTALFONTZLCD_BUFFER_H__
+#define __CRYSTALFONTZLCD_BUFFER_H__
+
+#include <stdint.h>
+
+typedef struct
+{
+    // LCD_HORIZONTAL_MAX * sRows pixels, row-major
+    uint16_t *pusPixels;
+    // First screen row held in the buffer
+    int16_t sYOrigin;
+    // Number of rows held in the buffer
+    int16_t sRows;
+} Crystalfontz128x128_Buffer;
+
+extern void Crystalfontz128x128_BufferFill(const Crystalfontz128x128_Buffer *psBuffer,
+                                           int16_t x0, int16_t y0,
+                                           int16_t x1, int16_t y1,
+                                           uint16_t ulValue);
+
+extern void Crystalfontz128x128_BufferWrite(const Crystalfontz128x128_Buffer *psBuffer,
+                                            int16_t x, int16_t y,
+                                            const uint8_t *pucData,
+                                            uint16_t usBytes);
+
+extern const uint8_t *Crystalfontz128x128_BufferRow(const Crystalfontz128x128_Buffer *psBuffer,
+                                                    int16_t x, int16_t y);
+
+#endif /* __CRYSTALFONTZLCD_BUFFER_H__ */
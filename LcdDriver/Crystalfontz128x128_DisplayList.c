@@ -0,0 +1,518 @@
+//*****************************************************************************
+//
+// Crystalfontz128x128_DisplayList.c - Deferred drawing for the Crystalfontz
+//                                     128x128 display driver.
+//
+// Every drawing call becomes a command: a rectangle of one color, or a row
+// of image pixels copied into the pixel arena.  Single-color rows of 1bpp
+// images become one rectangle per run of bits, so text ends up as spans
+// that merge like everything else.  Nothing reaches the panel until the
+// list is sent, on Flush or when the arena is full.
+//
+//*****************************************************************************
+
+#include "Crystalfontz128x128_DisplayList.h"
+#include "Crystalfontz128x128_ST7735.h"
+#include "HAL_MSP_EXP432P401R_Crystalfontz128x128_ST7735.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+typedef enum
+{
+    LCD_LIST_FILL,
+    LCD_LIST_PIXELS,
+    LCD_LIST_DROPPED
+} Lcd_ListType;
+
+typedef struct
+{
+    // Inclusive screen coordinates; one row for LCD_LIST_PIXELS
+    Graphics_Rectangle sRect;
+    // The color for LCD_LIST_FILL, else the first pixel in Lcd_ListPixels
+    uint16_t usValue;
+    uint8_t ucType;
+} Lcd_ListCommand;
+
+static Lcd_ListCommand Lcd_ListCommands[LCD_DISPLAY_LIST_COMMANDS];
+static uint16_t Lcd_ListCount;
+
+// Pixels of the LCD_LIST_PIXELS commands, in the panel's byte order, as
+// for Crystalfontz128x128_DrawNativeImage()
+static uint16_t Lcd_ListPixels[LCD_DISPLAY_LIST_PIXELS];
+static uint16_t Lcd_ListPixelCount;
+
+static Crystalfontz128x128_ListStats Lcd_ListStats;
+
+
+//*****************************************************************************
+//
+// Returns true if rectangle psInner lies within rectangle psOuter.
+//
+//*****************************************************************************
+static bool Crystalfontz128x128_ListCovers(const Graphics_Rectangle *psOuter,
+                                           const Graphics_Rectangle *psInner)
+{
+    return (psInner->sXMin >= psOuter->sXMin) &&
+           (psInner->sXMax <= psOuter->sXMax) &&
+           (psInner->sYMin >= psOuter->sYMin) &&
+           (psInner->sYMax <= psOuter->sYMax);
+}
+
+
+#if LCD_IMAGE_FORMATS & LCD_IMAGE_1BPP
+//*****************************************************************************
+//
+// Returns bit n of pucData, most significant bit first.
+//
+//*****************************************************************************
+static uint8_t Crystalfontz128x128_ListBit(const uint8_t *pucData, int16_t n)
+{
+    return (pucData[n >> 3] >> (7 - (n & 7))) & 1;
+}
+#endif
+
+
+//*****************************************************************************
+//
+// Returns true if two rectangles share a pixel.
+//
+//*****************************************************************************
+static bool Crystalfontz128x128_ListOverlap(const Graphics_Rectangle *a,
+                                            const Graphics_Rectangle *b)
+{
+    return (a->sXMin <= b->sXMax) && (b->sXMin <= a->sXMax) &&
+           (a->sYMin <= b->sYMax) && (b->sYMin <= a->sYMax);
+}
+
+
+//*****************************************************************************
+//
+// Merges fill b into fill a when they are the same color and together make
+// a rectangle: the same rows, side by side or overlapping, or the same
+// columns, one on top of the other.  Only valid when nothing is drawn
+// between them, since b then ends up drawn at a's place in the list.
+//
+//*****************************************************************************
+static bool Crystalfontz128x128_ListMerge(Lcd_ListCommand *a,
+                                          const Lcd_ListCommand *b)
+{
+    Graphics_Rectangle *psA = &a->sRect;
+    const Graphics_Rectangle *psB = &b->sRect;
+
+    if ((a->ucType != LCD_LIST_FILL) || (b->ucType != LCD_LIST_FILL) ||
+        (a->usValue != b->usValue))
+    {
+        return false;
+    }
+
+    if ((psA->sYMin == psB->sYMin) && (psA->sYMax == psB->sYMax) &&
+        (psB->sXMin <= psA->sXMax + 1) && (psA->sXMin <= psB->sXMax + 1))
+    {
+        if (psB->sXMin < psA->sXMin) psA->sXMin = psB->sXMin;
+        if (psB->sXMax > psA->sXMax) psA->sXMax = psB->sXMax;
+        return true;
+    }
+
+    if ((psA->sXMin == psB->sXMin) && (psA->sXMax == psB->sXMax) &&
+        (psB->sYMin <= psA->sYMax + 1) && (psA->sYMin <= psB->sYMax + 1))
+    {
+        if (psB->sYMin < psA->sYMin) psA->sYMin = psB->sYMin;
+        if (psB->sYMax > psA->sYMax) psA->sYMax = psB->sYMax;
+        return true;
+    }
+
+    return false;
+}
+
+
+//*****************************************************************************
+//
+// Returns true if command a should be sent before command b: rows top to
+// bottom, then left to right.
+//
+//*****************************************************************************
+static bool Crystalfontz128x128_ListBefore(const Lcd_ListCommand *a,
+                                           const Lcd_ListCommand *b)
+{
+    if (a->sRect.sYMin != b->sRect.sYMin)
+        return a->sRect.sYMin < b->sRect.sYMin;
+    return a->sRect.sXMin < b->sRect.sXMin;
+}
+
+
+//*****************************************************************************
+//
+// Sends the recorded commands to the driver and empties the list.
+//
+//*****************************************************************************
+static void Crystalfontz128x128_ListSend(const Graphics_Display *pDisplay)
+{
+    const Graphics_Display_Functions *psFuncs = &g_sCrystalfontz128x128_funcs;
+    uint32_t ulBytes = HAL_LCD_getBytesSent();
+    Lcd_ListCommand sCommand;
+    uint16_t i, j, n;
+
+    //
+    // Anything entirely drawn over by a later fill never needs sending.
+    //
+    for (i = 0; i < Lcd_ListCount; i++)
+    {
+        for (j = i + 1; j < Lcd_ListCount; j++)
+        {
+            if ((Lcd_ListCommands[j].ucType == LCD_LIST_FILL) &&
+                Crystalfontz128x128_ListCovers(&Lcd_ListCommands[j].sRect,
+                                               &Lcd_ListCommands[i].sRect))
+            {
+                Lcd_ListCommands[i].ucType = LCD_LIST_DROPPED;
+                Lcd_ListStats.ulDropped++;
+                break;
+            }
+        }
+    }
+
+    //
+    // Compact the list, sorting it by row on the way.  A command only moves
+    // ahead of the ones it does not overlap, so whatever is drawn over still
+    // ends up on top.
+    //
+    n = 0;
+    for (i = 0; i < Lcd_ListCount; i++)
+    {
+        if (Lcd_ListCommands[i].ucType == LCD_LIST_DROPPED)
+            continue;
+
+        sCommand = Lcd_ListCommands[i];
+        for (j = n; j > 0; j--)
+        {
+            if (!Crystalfontz128x128_ListBefore(&sCommand, &Lcd_ListCommands[j - 1]) ||
+                Crystalfontz128x128_ListOverlap(&sCommand.sRect,
+                                                &Lcd_ListCommands[j - 1].sRect))
+            {
+                break;
+            }
+            Lcd_ListCommands[j] = Lcd_ListCommands[j - 1];
+        }
+        Lcd_ListCommands[j] = sCommand;
+        n++;
+    }
+
+    //
+    // Spans that are now next to each other in the list and of one color
+    // go out as one.
+    //
+    j = 0;
+    for (i = 1; i < n; i++)
+    {
+        if (Crystalfontz128x128_ListMerge(&Lcd_ListCommands[j], &Lcd_ListCommands[i]))
+        {
+            Lcd_ListStats.ulMerged++;
+            continue;
+        }
+        Lcd_ListCommands[++j] = Lcd_ListCommands[i];
+    }
+    if (n)
+        n = j + 1;
+
+    for (i = 0; i < n; i++)
+    {
+        const Lcd_ListCommand *psCommand = &Lcd_ListCommands[i];
+
+        if (psCommand->ucType == LCD_LIST_FILL)
+        {
+            psFuncs->pfnRectFill(pDisplay, &psCommand->sRect, psCommand->usValue);
+        }
+        else
+        {
+            //
+            // Sent as a native image rather than a 16bpp row, which
+            // LCD_IMAGE_FORMATS may leave out.
+            //
+            Crystalfontz128x128_DrawNativeImage(psCommand->sRect.sXMin,
+                                                psCommand->sRect.sYMin,
+                                                psCommand->sRect.sXMax - psCommand->sRect.sXMin + 1,
+                                                1,
+                                                (const uint8_t *)&Lcd_ListPixels[psCommand->usValue]);
+        }
+    }
+
+    Lcd_ListStats.ulExecuted += n;
+    Lcd_ListStats.ulBytesSent += HAL_LCD_getBytesSent() - ulBytes;
+    Lcd_ListCount = 0;
+    Lcd_ListPixelCount = 0;
+}
+
+
+//*****************************************************************************
+//
+// Appends a command, merged into the last one when possible.  The list is
+// sent first when it is full.
+//
+//*****************************************************************************
+static void Crystalfontz128x128_ListAdd(const Graphics_Display *pDisplay,
+                                        const Lcd_ListCommand *psCommand)
+{
+    if (Lcd_ListCount &&
+        Crystalfontz128x128_ListMerge(&Lcd_ListCommands[Lcd_ListCount - 1], psCommand))
+    {
+        Lcd_ListStats.ulMerged++;
+        return;
+    }
+
+    if (Lcd_ListCount == LCD_DISPLAY_LIST_COMMANDS)
+    {
+        Crystalfontz128x128_ListSend(pDisplay);
+    }
+
+    Lcd_ListCommands[Lcd_ListCount++] = *psCommand;
+}
+
+
+//*****************************************************************************
+//
+// Records a rectangle of one color.
+//
+//*****************************************************************************
+static void Crystalfontz128x128_ListFill(const Graphics_Display *pDisplay,
+                                         int16_t x0, int16_t y0,
+                                         int16_t x1, int16_t y1,
+                                         uint16_t ulValue)
+{
+    Lcd_ListCommand sCommand;
+
+    sCommand.sRect.sXMin = x0;
+    sCommand.sRect.sYMin = y0;
+    sCommand.sRect.sXMax = x1;
+    sCommand.sRect.sYMax = y1;
+    sCommand.usValue = ulValue;
+    sCommand.ucType = LCD_LIST_FILL;
+    Crystalfontz128x128_ListAdd(pDisplay, &sCommand);
+}
+
+
+//*****************************************************************************
+//
+// Records a pixel, as a rectangle of one pixel so that the pixels of a line
+// merge into spans.
+//
+//*****************************************************************************
+static void Crystalfontz128x128_ListPixelDraw(const Graphics_Display *pDisplay,
+                                              int16_t lX, int16_t lY,
+                                              uint16_t ulValue)
+{
+    Lcd_ListStats.ulRecorded++;
+    Crystalfontz128x128_ListFill(pDisplay, lX, lY, lX, lY, ulValue);
+}
+
+
+//*****************************************************************************
+//
+// Records a row of pixels.  1bpp rows become one fill per run of bits; the
+// others are expanded into the pixel arena with their palette applied.
+//
+//*****************************************************************************
+static void Crystalfontz128x128_ListPixelDrawMultiple(const Graphics_Display *pDisplay,
+                                                      int16_t lX, int16_t lY,
+                                                      int16_t lX0, int16_t lCount,
+                                                      int16_t lBPP,
+                                                      const uint8_t *pucData,
+                                                      const uint32_t *pucPalette)
+{
+    Lcd_ListCommand sCommand;
+    uint8_t *pucOut;
+    uint16_t usColor;
+    int16_t i;
+
+    Lcd_ListStats.ulRecorded++;
+
+    if (lCount <= 0)
+        return;
+    if (lCount > LCD_HORIZONTAL_MAX)
+        lCount = LCD_HORIZONTAL_MAX;
+
+#if LCD_IMAGE_FORMATS & LCD_IMAGE_1BPP
+    if (lBPP == 1)
+    {
+        int16_t lEnd;
+        uint8_t ucBit;
+
+        lX0 &= 7;
+        for (i = 0; i < lCount; i = lEnd)
+        {
+            ucBit = Crystalfontz128x128_ListBit(pucData, lX0 + i);
+            for (lEnd = i + 1; lEnd < lCount; lEnd++)
+            {
+                if (Crystalfontz128x128_ListBit(pucData, lX0 + lEnd) != ucBit)
+                    break;
+            }
+            Crystalfontz128x128_ListFill(pDisplay, lX + i, lY, lX + lEnd - 1, lY,
+                                         (uint16_t)pucPalette[ucBit]);
+        }
+        return;
+    }
+#endif
+
+    //
+    // Only the formats of LCD_IMAGE_FORMATS are drawn, as by the driver.
+    //
+    if (!(((lBPP == 4) && (LCD_IMAGE_FORMATS & LCD_IMAGE_4BPP)) ||
+          ((lBPP == 8) && (LCD_IMAGE_FORMATS & LCD_IMAGE_8BPP)) ||
+          ((lBPP == 16) && (LCD_IMAGE_FORMATS & LCD_IMAGE_16BPP))))
+        return;
+
+    //
+    // Make room before writing the pixels, since sending the list empties
+    // the pixel arena too.
+    //
+    if ((Lcd_ListPixelCount + lCount > LCD_DISPLAY_LIST_PIXELS) ||
+        (Lcd_ListCount == LCD_DISPLAY_LIST_COMMANDS))
+    {
+        Crystalfontz128x128_ListSend(pDisplay);
+    }
+
+    pucOut = (uint8_t *)&Lcd_ListPixels[Lcd_ListPixelCount];
+    for (i = 0; i < lCount; i++)
+    {
+        switch (lBPP)
+        {
+#if LCD_IMAGE_FORMATS & LCD_IMAGE_4BPP
+            case 4:
+                usColor = (uint16_t)pucPalette[(pucData[((lX0 & 1) + i) >> 1] >>
+                                                ((((lX0 & 1) + i) & 1) ? 0 : 4)) & 15];
+                break;
+#endif
+#if LCD_IMAGE_FORMATS & LCD_IMAGE_8BPP
+            case 8:
+                usColor = (uint16_t)pucPalette[pucData[i]];
+                break;
+#endif
+            default:
+                usColor = ((const uint16_t *)pucData)[i];
+                break;
+        }
+        *pucOut++ = usColor >> 8;
+        *pucOut++ = usColor;
+    }
+
+    sCommand.sRect.sXMin = lX;
+    sCommand.sRect.sYMin = lY;
+    sCommand.sRect.sXMax = lX + lCount - 1;
+    sCommand.sRect.sYMax = lY;
+    sCommand.usValue = Lcd_ListPixelCount;
+    sCommand.ucType = LCD_LIST_PIXELS;
+    Lcd_ListPixelCount += lCount;
+    Crystalfontz128x128_ListAdd(pDisplay, &sCommand);
+}
+
+
+static void Crystalfontz128x128_ListLineDrawH(const Graphics_Display *pDisplay,
+                                              int16_t lX1, int16_t lX2,
+                                              int16_t lY, uint16_t ulValue)
+{
+    Lcd_ListStats.ulRecorded++;
+    Crystalfontz128x128_ListFill(pDisplay, lX1, lY, lX2, lY, ulValue);
+}
+
+
+static void Crystalfontz128x128_ListLineDrawV(const Graphics_Display *pDisplay,
+                                              int16_t lX, int16_t lY1,
+                                              int16_t lY2, uint16_t ulValue)
+{
+    Lcd_ListStats.ulRecorded++;
+    Crystalfontz128x128_ListFill(pDisplay, lX, lY1, lX, lY2, ulValue);
+}
+
+
+static void Crystalfontz128x128_ListRectFill(const Graphics_Display *pDisplay,
+                                             const Graphics_Rectangle *pRect,
+                                             uint16_t ulValue)
+{
+    Lcd_ListStats.ulRecorded++;
+    Crystalfontz128x128_ListFill(pDisplay, pRect->sXMin, pRect->sYMin,
+                                 pRect->sXMax, pRect->sYMax, ulValue);
+}
+
+
+static uint32_t Crystalfontz128x128_ListColorTranslate(const Graphics_Display *pDisplay,
+                                                       uint32_t ulValue)
+{
+    return g_sCrystalfontz128x128_funcs.pfnColorTranslate(pDisplay, ulValue);
+}
+
+
+//*****************************************************************************
+//
+// Sends the list, then flushes the driver itself, which waits for the last
+// transfer.
+//
+//*****************************************************************************
+static void Crystalfontz128x128_ListFlush(const Graphics_Display *pDisplay)
+{
+    Crystalfontz128x128_ListSend(pDisplay);
+    g_sCrystalfontz128x128_funcs.pfnFlush(pDisplay);
+}
+
+
+//*****************************************************************************
+//
+// Records a clear as a full-screen fill, which drops everything recorded
+// before it.
+//
+//*****************************************************************************
+static void Crystalfontz128x128_ListClearScreen(const Graphics_Display *pDisplay,
+                                                uint16_t ulValue)
+{
+    Lcd_ListStats.ulRecorded++;
+    Crystalfontz128x128_ListFill(pDisplay, 0, 0, LCD_HORIZONTAL_MAX - 1,
+                                 LCD_VERTICAL_MAX - 1, ulValue);
+}
+
+
+//*****************************************************************************
+//
+//! Returns the counters of the display list since the last reset.
+//!
+//! \param psStats receives the counters.  Bytes are counted as the list is
+//! sent, so the commands still waiting for a flush are not in ulBytesSent.
+//!
+//! \return None.
+//
+//*****************************************************************************
+void Crystalfontz128x128_GetListStats(Crystalfontz128x128_ListStats *psStats)
+{
+    *psStats = Lcd_ListStats;
+}
+
+
+//*****************************************************************************
+//
+//! Clears the counters of the display list.
+//!
+//! \return None.
+//
+//*****************************************************************************
+void Crystalfontz128x128_ResetListStats(void)
+{
+    Lcd_ListStats.ulRecorded = 0;
+    Lcd_ListStats.ulDropped = 0;
+    Lcd_ListStats.ulMerged = 0;
+    Lcd_ListStats.ulExecuted = 0;
+    Lcd_ListStats.ulBytesSent = 0;
+}
+
+
+//*****************************************************************************
+//
+//! The functions of a grlib context that records into the display list.
+//
+//*****************************************************************************
+const Graphics_Display_Functions g_sCrystalfontz128x128_listFuncs =
+{
+    Crystalfontz128x128_ListPixelDraw,
+    Crystalfontz128x128_ListPixelDrawMultiple,
+    Crystalfontz128x128_ListLineDrawH,
+    Crystalfontz128x128_ListLineDrawV,
+    Crystalfontz128x128_ListRectFill,
+    Crystalfontz128x128_ListColorTranslate,
+    Crystalfontz128x128_ListFlush,
+    Crystalfontz128x128_ListClearScreen
+};
@@ -0,0 +1,57 @@
+//*****************************************************************************
+//
+// Crystalfontz128x128_DisplayList.h - Deferred drawing for the Crystalfontz
+//                                     128x128 display driver.
+//
+// A grlib context set up with g_sCrystalfontz128x128_listFuncs records what
+// is drawn instead of sending it.  Graphics_flushBuffer() then drops what is
+// drawn over, sorts the rest by row, merges adjacent spans of one color, and
+// sends what is left back to back through g_sCrystalfontz128x128_funcs:
+//
+//     Graphics_initContext(&context, &g_sCrystalfontz128x128,
+//                          &g_sCrystalfontz128x128_listFuncs);
+//
+//*****************************************************************************
+
+#ifndef __CRYSTALFONTZLCD_DISPLAYLIST_H__
+#define __CRYSTALFONTZLCD_DISPLAYLIST_H__
+
+#include <stdint.h>
+#include <ti/grlib/grlib.h>
+
+// Drawing commands held before the list has to be sent
+#ifndef LCD_DISPLAY_LIST_COMMANDS
+#define LCD_DISPLAY_LIST_COMMANDS          64
+#endif
+
+// Pixels of image data held, for the rows drawn with PixelDrawMultiple that
+// are not a single color; at least one row
+#ifndef LCD_DISPLAY_LIST_PIXELS
+#define LCD_DISPLAY_LIST_PIXELS            512
+#endif
+
+#if LCD_DISPLAY_LIST_PIXELS < 128
+#error "LCD_DISPLAY_LIST_PIXELS must hold at least one row"
+#endif
+
+typedef struct
+{
+    // Drawing calls recorded
+    uint32_t ulRecorded;
+    // Commands left out because a later rectangle covered them
+    uint32_t ulDropped;
+    // Commands joined to a neighbour of the same color
+    uint32_t ulMerged;
+    // Commands sent to the driver
+    uint32_t ulExecuted;
+    // Bytes the driver sent to the panel for them, commands included
+    uint32_t ulBytesSent;
+} Crystalfontz128x128_ListStats;
+
+extern const Graphics_Display_Functions g_sCrystalfontz128x128_listFuncs;
+
+extern void Crystalfontz128x128_GetListStats(Crystalfontz128x128_ListStats *psStats);
+
+extern void Crystalfontz128x128_ResetListStats(void);
+
+#endif /* __CRYSTALFONTZLCD_DISPLAYLIST_H__ */
@@ -40,154 +40,1487 @@
 #include "Crystalfontz128x128_ST7735.h"
 #include <ti/devices/msp432p4xx/driverlib/driverlib.h>
 #include "HAL_MSP_EXP432P401R_Crystalfontz128x128_ST7735.h"
+#include "Crystalfontz128x128_Buffer.h"
 #include <stdint.h>
+#include "profiler.h"
+#include "sleep_manager.h"
+
+// Palettes are only cached for the formats that have them
+#define LCD_PALETTE_CACHED  ((LCD_PALETTE_CACHE_ENTRIES > 0) && \
+                             (LCD_IMAGE_FORMATS & (LCD_IMAGE_4BPP | LCD_IMAGE_8BPP)))
+
+#if !defined(LCD_PANEL_OFFSET_X) || !defined(LCD_PANEL_OFFSET_Y)
+// Where screen (0, 0) is in the panel's frame memory, for each orientation
+typedef struct
+{
+    uint8_t ucX;
+    uint8_t ucY;
+} Lcd_Offset;
+
+static const Lcd_Offset Lcd_Offsets[4] =
+{
+    { 2, 3 },   // LCD_ORIENTATION_UP
+    { 3, 2 },   // LCD_ORIENTATION_LEFT
+    { 2, 1 },   // LCD_ORIENTATION_DOWN
+    { 1, 2 }    // LCD_ORIENTATION_RIGHT
+};
+#endif
+
+// With a fixed orientation, every use of these folds into a constant
+#if LCD_FIXED_ORIENTATION == LCD_ORIENTATION_RUNTIME
+static uint8_t Lcd_Orientation = LCD_ORIENTATION_UP;
+#define LCD_CURRENT_ORIENTATION  Lcd_Orientation
+#else
+#define LCD_CURRENT_ORIENTATION  LCD_FIXED_ORIENTATION
+#endif
+
+#ifndef LCD_PANEL_OFFSET_X
+#define LCD_PANEL_OFFSET_X  (Lcd_Offsets[LCD_CURRENT_ORIENTATION].ucX)
+#endif
+#ifndef LCD_PANEL_OFFSET_Y
+#define LCD_PANEL_OFFSET_Y  (Lcd_Offsets[LCD_CURRENT_ORIENTATION].ucY)
+#endif
+
+// Rows of decoded image data waiting for (or being sent by) the DMA.  While
+// one is on the wire, the next row is decoded into the other.
+static uint16_t Lcd_LineBuffer[2][LCD_HORIZONTAL_MAX];
+static uint8_t Lcd_LineBufferIndex;
+
+#if LCD_COLOR_DEPTH == 12
+// Rows packed to 12 bits per pixel, alternating the same way as the line
+// buffers
+static uint8_t Lcd_PackedLine[2][LCD_HORIZONTAL_MAX * 3 / 2];
+static uint8_t Lcd_PackedLineIndex;
+#endif
+
+#if LCD_PALETTE_CACHED
+// Image palettes already in the panel's byte order, so that 4 and 8bpp rows
+// expand with one table lookup per pixel.  grlib passes the same palette for
+// every row of an image, so the translation cost is paid once per image.
+typedef struct
+{
+    const uint32_t *pulPalette;
+    uint16_t usEntries;
+    uint16_t pusColors[256];
+} Lcd_PaletteCacheEntry;
+
+static Lcd_PaletteCacheEntry Lcd_PaletteCache[LCD_PALETTE_CACHE_ENTRIES];
+static uint8_t Lcd_PaletteCacheNext;
+#endif
+
+// Address window last sent to the panel, after the orientation offset, so
+// that CASET and RASET are only sent when they change
+static uint16_t Lcd_FrameX0, Lcd_FrameX1, Lcd_FrameY0, Lcd_FrameY1;
+static bool Lcd_FrameValid;
+
+// Where the panel's write pointer is when the last thing sent was a RAMWR
+// from PixelDraw; the next pixel at that position needs no command at all
+static int16_t Lcd_CursorX, Lcd_CursorY;
+static bool Lcd_CursorValid;
+
+// Scrolling area set by Crystalfontz128x128_SetScrollArea(), in drawing
+// coordinates along the panel's scan direction
+static uint16_t Lcd_ScrollTop, Lcd_ScrollHeight, Lcd_ScrollBottom;
+
+// Steps of Crystalfontz128x128_InitAsync(), each started by a timer or by the
+// end of the DMA transfer of the step before
+typedef enum
+{
+    LCD_INIT_IDLE,
+    LCD_INIT_RESET,
+    LCD_INIT_SLEEP_OUT,
+    LCD_INIT_CONFIGURE,
+    LCD_INIT_CONFIGURED,
+    LCD_INIT_DISPLAY_ON,
+    LCD_INIT_DONE
+} Lcd_InitState;
+
+static volatile Lcd_InitState Lcd_InitStep = LCD_INIT_IDLE;
+static void (*Lcd_InitDone)(void);
+
+static void Crystalfontz128x128_Configure(void);
+
+
+#if LCD_COLOR_DEPTH == 12
+//*****************************************************************************
+//
+// Converts an RGB565 color to RGB444, from the top bits of each component.
+//
+//*****************************************************************************
+static uint16_t Crystalfontz128x128_To444(uint16_t ulValue)
+{
+    return ((ulValue >> 4) & 0x0F00) | ((ulValue >> 3) & 0x00F0) |
+           ((ulValue >> 1) & 0x000F);
+}
+
+
+//*****************************************************************************
+//
+// Packs ulPixels RGB565 pixels, in the panel's byte order, into pucOut at 12
+// bits per pixel: each pair becomes three bytes.  An odd last pixel takes two
+// bytes, the last four bits of which the panel drops.  Returns the number of
+// bytes written.
+//
+//*****************************************************************************
+static uint32_t Crystalfontz128x128_Pack444(const uint8_t *pucLine,
+                                            uint32_t ulPixels,
+                                            uint8_t *pucOut)
+{
+    uint8_t *pucStart = pucOut;
+    uint16_t us0, us1;
+
+    for (; ulPixels >= 2; ulPixels -= 2)
+    {
+        us0 = Crystalfontz128x128_To444((pucLine[0] << 8) | pucLine[1]);
+        us1 = Crystalfontz128x128_To444((pucLine[2] << 8) | pucLine[3]);
+        pucLine += 4;
+
+        *pucOut++ = us0 >> 4;
+        *pucOut++ = (us0 << 4) | (us1 >> 8);
+        *pucOut++ = us1;
+    }
+
+    if (ulPixels)
+    {
+        us0 = Crystalfontz128x128_To444((pucLine[0] << 8) | pucLine[1]);
+        *pucOut++ = us0 >> 4;
+        *pucOut++ = us0 << 4;
+    }
+
+    return pucOut - pucStart;
+}
+#endif
+
+
+//*****************************************************************************
+//
+// Sends count pixels of the same color after a RAMWR.  Long spans are handed
+// to the DMA so the CPU is free while they are on the wire.
+//
+//*****************************************************************************
+static void Crystalfontz128x128_WriteColor(uint16_t ulValue, uint32_t count)
+{
+#if LCD_COLOR_DEPTH == 12
+    uint16_t us444 = Crystalfontz128x128_To444(ulValue);
+    uint8_t pucPair[3];
+
+    pucPair[0] = us444 >> 4;
+    pucPair[1] = (us444 << 4) | (us444 >> 8);
+    pucPair[2] = us444;
+
+    if (count >= LCD_DMA_THRESHOLD)
+    {
+        HAL_LCD_fillPatternDMA(pucPair, 3, count / 2);
+    }
+    else
+    {
+        HAL_LCD_writeRepeat(pucPair, 3, count / 2);
+    }
+
+    //
+    // The odd pixel out is sent alone; its first two bytes are the same as
+    // those of a pair.
+    //
+    if (count & 1)
+    {
+        HAL_LCD_writeBurst(pucPair, 2);
+    }
+    return;
+#endif
+
+    if (count >= LCD_DMA_THRESHOLD)
+    {
+        HAL_LCD_fillDMA(ulValue, count);
+        return;
+    }
+
+    HAL_LCD_writeRepeat16(ulValue, count);
+}
+
+
+//*****************************************************************************
+//
+// Sends a decoded line buffer after a RAMWR, through the DMA when it is long
+// enough to be worth it.
+//
+//*****************************************************************************
+static void Crystalfontz128x128_WriteLine(const uint8_t *pucLine, uint32_t len)
+{
+#if LCD_COLOR_DEPTH == 12
+    uint32_t ulPixels = len / 2;
+    uint32_t ulChunk, ulBytes;
+    uint8_t *pucPacked;
+
+    //
+    // Pack a row at a time, so one packed row is on the wire while the next
+    // is packed.  The pixels are contiguous and the rows of 128 pixels an
+    // even number, so the pairs carry on across them; only the end of the
+    // line may hold an odd pixel, which must also end the RAMWR.
+    //
+    while (ulPixels)
+    {
+        ulChunk = (ulPixels > LCD_HORIZONTAL_MAX) ? LCD_HORIZONTAL_MAX : ulPixels;
+        pucPacked = Lcd_PackedLine[Lcd_PackedLineIndex];
+        Lcd_PackedLineIndex ^= 1;
+
+        ulBytes = Crystalfontz128x128_Pack444(pucLine, ulChunk, pucPacked);
+        if (ulChunk >= LCD_DMA_THRESHOLD)
+        {
+            HAL_LCD_writeDataDMA(pucPacked, ulBytes);
+        }
+        else
+        {
+            HAL_LCD_writeBurst(pucPacked, ulBytes);
+        }
+
+        pucLine += ulChunk * 2;
+        ulPixels -= ulChunk;
+    }
+    return;
+#endif
+
+    if (len >= LCD_DMA_THRESHOLD * 2)
+    {
+        HAL_LCD_writeDataDMA(pucLine, len);
+        return;
+    }
+
+    HAL_LCD_writeBurst(pucLine, len);
+}
+
+
+#if LCD_PALETTE_CACHED
+//*****************************************************************************
+//
+// Returns the palette translated to the panel's byte order, with at least
+// usEntries entries valid.  Palettes are replaced round-robin.
+//
+//*****************************************************************************
+static const uint16_t *Crystalfontz128x128_GetPalette(const uint32_t *pulPalette,
+                                                      uint16_t usEntries)
+{
+    Lcd_PaletteCacheEntry *psEntry = 0;
+    uint16_t usColor;
+    uint16_t i;
+
+    for (i = 0; i < LCD_PALETTE_CACHE_ENTRIES; i++)
+    {
+        if (Lcd_PaletteCache[i].pulPalette == pulPalette)
+        {
+            psEntry = &Lcd_PaletteCache[i];
+            break;
+        }
+    }
+
+    if (psEntry == 0)
+    {
+        psEntry = &Lcd_PaletteCache[Lcd_PaletteCacheNext];
+        Lcd_PaletteCacheNext = (Lcd_PaletteCacheNext + 1) % LCD_PALETTE_CACHE_ENTRIES;
+        psEntry->pulPalette = pulPalette;
+        psEntry->usEntries = 0;
+    }
+
+    for (i = psEntry->usEntries; i < usEntries; i++)
+    {
+        usColor = *(const uint16_t *)(pulPalette + i);
+        psEntry->pusColors[i] = (usColor >> 8) | (usColor << 8);
+    }
+    if (usEntries > psEntry->usEntries)
+    {
+        psEntry->usEntries = usEntries;
+    }
+
+    return psEntry->pusColors;
+}
+#endif
+
+
+//*****************************************************************************
+//
+// Fills a rectangle on the panel.
+//
+//*****************************************************************************
+static void Crystalfontz128x128_FillDirect(int16_t x0, int16_t y0,
+                                           int16_t x1, int16_t y1,
+                                           uint16_t ulValue)
+{
+    Crystalfontz128x128_SetDrawFrame(x0, y0, x1, y1);
+
+    //
+    // Write the pixel value.
+    //
+    HAL_LCD_writeCommand(CM_RAMWR);
+    Crystalfontz128x128_WriteColor(ulValue,
+                                   (uint32_t)(x1 - x0 + 1) * (y1 - y0 + 1));
+}
+
+
+#if LCD_BUFFERED_DRAWING
+//*****************************************************************************
+//
+// Local framebuffer.  While buffering is on, anything drawn on the rows it
+// holds is rendered here and only reaches the panel on Flush; rows outside
+// of it are still drawn directly.
+//
+// Crystalfontz128x128_RenderStrips() points it at each strip buffer in turn,
+// with Lcd_Stripping set: then rows outside of it are dropped instead, and
+// nothing is tracked as dirty since every strip is sent whole.
+//
+//*****************************************************************************
+#if LCD_FRAMEBUFFER_ROWS > 0
+static uint16_t Lcd_FrameBufferPixels[LCD_FRAMEBUFFER_ROWS * LCD_HORIZONTAL_MAX];
+static Crystalfontz128x128_Buffer Lcd_FrameBuffer =
+{
+    Lcd_FrameBufferPixels,
+    0,
+    LCD_FRAMEBUFFER_ROWS
+};
+#else
+static Crystalfontz128x128_Buffer Lcd_FrameBuffer;
+#endif
+static bool Lcd_Buffered;
+static bool Lcd_Stripping;
+
+#if LCD_STRIP_ROWS > 0
+// One strip is rendered while the other is on its way to the panel
+static uint16_t Lcd_StripPixels[2][LCD_STRIP_ROWS * LCD_HORIZONTAL_MAX];
+#endif
+
+// Regions of the framebuffer that differ from the panel
+static Graphics_Rectangle Lcd_DirtyRects[LCD_FRAMEBUFFER_DIRTY_RECTS];
+static uint8_t Lcd_DirtyCount;
+
+static bool Crystalfontz128x128_InBuffer(int16_t y)
+{
+    return Lcd_Buffered &&
+           (y >= Lcd_FrameBuffer.sYOrigin) &&
+           (y < Lcd_FrameBuffer.sYOrigin + Lcd_FrameBuffer.sRows);
+}
+
+// True if the rectangles overlap or share an edge
+static bool Crystalfontz128x128_RectsTouch(const Graphics_Rectangle *a,
+                                           const Graphics_Rectangle *b)
+{
+    return (a->sXMin <= b->sXMax + 1) && (b->sXMin <= a->sXMax + 1) &&
+           (a->sYMin <= b->sYMax + 1) && (b->sYMin <= a->sYMax + 1);
+}
+
+static void Crystalfontz128x128_RectUnion(Graphics_Rectangle *a,
+                                          const Graphics_Rectangle *b)
+{
+    if (b->sXMin < a->sXMin) a->sXMin = b->sXMin;
+    if (b->sYMin < a->sYMin) a->sYMin = b->sYMin;
+    if (b->sXMax > a->sXMax) a->sXMax = b->sXMax;
+    if (b->sYMax > a->sYMax) a->sYMax = b->sYMax;
+}
+
+static int32_t Crystalfontz128x128_RectArea(const Graphics_Rectangle *a)
+{
+    return (int32_t)(a->sXMax - a->sXMin + 1) * (a->sYMax - a->sYMin + 1);
+}
+
+//*****************************************************************************
+//
+// Records a region of the framebuffer as needing to be sent.  The new region
+// absorbs every dirty rectangle it touches.  When the list is full, it is
+// merged with the rectangle whose bounding box grows the least.
+//
+//*****************************************************************************
+static void Crystalfontz128x128_AddDirty(int16_t x0, int16_t y0,
+                                         int16_t x1, int16_t y1)
+{
+    Graphics_Rectangle sNew = { x0, y0, x1, y1 };
+    bool bMerged;
+    uint8_t i;
+
+    if (Lcd_Stripping)
+        return;
+
+    do
+    {
+        bMerged = false;
+        for (i = 0; i < Lcd_DirtyCount; i++)
+        {
+            if (Crystalfontz128x128_RectsTouch(&Lcd_DirtyRects[i], &sNew))
+            {
+                Crystalfontz128x128_RectUnion(&sNew, &Lcd_DirtyRects[i]);
+                Lcd_DirtyRects[i] = Lcd_DirtyRects[--Lcd_DirtyCount];
+                bMerged = true;
+                break;
+            }
+        }
+
+        if (!bMerged && (Lcd_DirtyCount == LCD_FRAMEBUFFER_DIRTY_RECTS))
+        {
+            int32_t lBestGrowth = INT32_MAX;
+            uint8_t ucBest = 0;
+
+            for (i = 0; i < Lcd_DirtyCount; i++)
+            {
+                Graphics_Rectangle sUnion = Lcd_DirtyRects[i];
+                int32_t lGrowth;
+
+                Crystalfontz128x128_RectUnion(&sUnion, &sNew);
+                lGrowth = Crystalfontz128x128_RectArea(&sUnion) -
+                          Crystalfontz128x128_RectArea(&Lcd_DirtyRects[i]);
+                if (lGrowth < lBestGrowth)
+                {
+                    lBestGrowth = lGrowth;
+                    ucBest = i;
+                }
+            }
+
+            Crystalfontz128x128_RectUnion(&sNew, &Lcd_DirtyRects[ucBest]);
+            Lcd_DirtyRects[ucBest] = Lcd_DirtyRects[--Lcd_DirtyCount];
+            bMerged = true;
+        }
+    } while (bMerged);
+
+    Lcd_DirtyRects[Lcd_DirtyCount++] = sNew;
+}
+
+#if LCD_COLOR_DEPTH == 12
+//*****************************************************************************
+//
+// Sends sRows rows of usWidth pixels from the framebuffer, starting at
+// pucRow, after a single RAMWR.  The panel reads the pixels as one stream,
+// so when usWidth is odd a pair straddles two rows; they are packed as one
+// stream too, instead of a row at a time.
+//
+//*****************************************************************************
+static void Crystalfontz128x128_WriteRows444(const uint8_t *pucRow,
+                                             uint16_t usWidth, int16_t sRows)
+{
+    uint32_t ulPixels = (uint32_t)usWidth * sRows;
+    const uint8_t *pucIn = pucRow;
+    uint16_t usX = 0;
+    uint32_t ulChunk, i;
+    uint8_t *pucPacked, *pucOut;
+    uint16_t us0 = 0, us1;
+
+    while (ulPixels)
+    {
+        //
+        // Chunks are an even number of pixels, except for the last, so
+        // only the last can end in the middle of a pair.
+        //
+        ulChunk = (ulPixels > LCD_HORIZONTAL_MAX) ? LCD_HORIZONTAL_MAX : ulPixels;
+        pucPacked = Lcd_PackedLine[Lcd_PackedLineIndex];
+        Lcd_PackedLineIndex ^= 1;
+        pucOut = pucPacked;
+
+        for (i = 0; i < ulChunk; i++)
+        {
+            us1 = Crystalfontz128x128_To444((pucIn[0] << 8) | pucIn[1]);
+            pucIn += 2;
+            if (++usX == usWidth)
+            {
+                usX = 0;
+                pucRow += LCD_HORIZONTAL_MAX * 2;
+                pucIn = pucRow;
+            }
+
+            if (i & 1)
+            {
+                *pucOut++ = (us0 << 4) | (us1 >> 8);
+                *pucOut++ = us1;
+            }
+            else
+            {
+                *pucOut++ = us1 >> 4;
+                us0 = us1;
+            }
+        }
+        if (ulChunk & 1)
+        {
+            *pucOut++ = us0 << 4;
+        }
+
+        if (ulChunk >= LCD_DMA_THRESHOLD)
+        {
+            HAL_LCD_writeDataDMA(pucPacked, pucOut - pucPacked);
+        }
+        else
+        {
+            HAL_LCD_writeBurst(pucPacked, pucOut - pucPacked);
+        }
+
+        ulPixels -= ulChunk;
+    }
+}
+#endif
+
+//*****************************************************************************
+//
+// Sends the dirty regions of the framebuffer to the panel.
+//
+//*****************************************************************************
+static void Crystalfontz128x128_FlushDirty(void)
+{
+    uint8_t i;
+
+    for (i = 0; i < Lcd_DirtyCount; i++)
+    {
+        const Graphics_Rectangle *psRect = &Lcd_DirtyRects[i];
+        uint16_t usBytes = (psRect->sXMax - psRect->sXMin + 1) * 2;
+#if LCD_COLOR_DEPTH != 12
+        int16_t y;
+#endif
+
+        Crystalfontz128x128_SetDrawFrame(psRect->sXMin, psRect->sYMin,
+                                         psRect->sXMax, psRect->sYMax);
+        HAL_LCD_writeCommand(CM_RAMWR);
+
+        if (usBytes == LCD_HORIZONTAL_MAX * 2)
+        {
+            // Full-width rows are contiguous in the buffer
+            Crystalfontz128x128_WriteLine(Crystalfontz128x128_BufferRow(&Lcd_FrameBuffer, 0, psRect->sYMin),
+                                          (uint32_t)usBytes * (psRect->sYMax - psRect->sYMin + 1));
+        }
+        else
+        {
+#if LCD_COLOR_DEPTH == 12
+            Crystalfontz128x128_WriteRows444(Crystalfontz128x128_BufferRow(&Lcd_FrameBuffer, psRect->sXMin, psRect->sYMin),
+                                             usBytes / 2, psRect->sYMax - psRect->sYMin + 1);
+#else
+            for (y = psRect->sYMin; y <= psRect->sYMax; y++)
+            {
+                Crystalfontz128x128_WriteLine(Crystalfontz128x128_BufferRow(&Lcd_FrameBuffer, psRect->sXMin, y),
+                                              usBytes);
+            }
+#endif
+        }
+    }
+
+    Lcd_DirtyCount = 0;
+}
+
+#if LCD_FRAMEBUFFER_ROWS > 0
+//*****************************************************************************
+//
+// Starts over with a cleared framebuffer.  Since it no longer matches the
+// panel, all of it is marked dirty.
+//
+//*****************************************************************************
+static void Crystalfontz128x128_ResetBuffer(void)
+{
+    int16_t y0 = Lcd_FrameBuffer.sYOrigin;
+    int16_t y1 = y0 + Lcd_FrameBuffer.sRows - 1;
+
+    Crystalfontz128x128_BufferFill(&Lcd_FrameBuffer, 0, y0,
+                                   LCD_HORIZONTAL_MAX - 1, y1, 0);
+    Lcd_DirtyCount = 0;
+    Crystalfontz128x128_AddDirty(0, y0, LCD_HORIZONTAL_MAX - 1, y1);
+}
+#endif
+#endif
+
+
+//*****************************************************************************
+//
+// Fills a rectangle, through the framebuffer for the rows it holds.
+//
+//*****************************************************************************
+static void Crystalfontz128x128_Fill(int16_t x0, int16_t y0,
+                                     int16_t x1, int16_t y1,
+                                     uint16_t ulValue)
+{
+#if LCD_BUFFERED_DRAWING
+    if (Lcd_Buffered)
+    {
+        int16_t sTop = Lcd_FrameBuffer.sYOrigin;
+        int16_t sBottom = sTop + Lcd_FrameBuffer.sRows - 1;
+
+        if ((y0 < sTop) && !Lcd_Stripping)
+        {
+            Crystalfontz128x128_FillDirect(x0, y0, x1,
+                                           (y1 < sTop) ? y1 : sTop - 1,
+                                           ulValue);
+        }
+        if ((y1 > sBottom) && !Lcd_Stripping)
+        {
+            Crystalfontz128x128_FillDirect(x0, (y0 > sBottom) ? y0 : sBottom + 1,
+                                           x1, y1, ulValue);
+        }
+        if ((y0 <= sBottom) && (y1 >= sTop))
+        {
+            if (y0 < sTop) y0 = sTop;
+            if (y1 > sBottom) y1 = sBottom;
+            Crystalfontz128x128_BufferFill(&Lcd_FrameBuffer, x0, y0, x1, y1,
+                                           ulValue);
+            Crystalfontz128x128_AddDirty(x0, y0, x1, y1);
+        }
+        return;
+    }
+#endif
+
+    Crystalfontz128x128_FillDirect(x0, y0, x1, y1, ulValue);
+}
+
+
+//*****************************************************************************
+//
+// Returns the length, at most lEnd - lBit, of the run of identical bits that
+// starts at bit lBit of pucData (most significant bit first), and the value
+// of those bits in *pucBit.  Whole bytes of 0x00 or 0xFF are skipped at once.
+//
+//*****************************************************************************
+static int16_t Crystalfontz128x128_MonoRun(const uint8_t *pucData,
+                                           int16_t lBit, int16_t lEnd,
+                                           uint8_t *pucBit)
+{
+    int16_t lStart = lBit;
+    uint8_t ucBit = (pucData[lBit >> 3] >> (7 - (lBit & 7))) & 1;
+    uint8_t ucFull = ucBit ? 0xFF : 0x00;
+
+    while (lBit < lEnd)
+    {
+        if (((lBit & 7) == 0) && (lBit + 8 <= lEnd) &&
+            (pucData[lBit >> 3] == ucFull))
+        {
+            lBit += 8;
+            continue;
+        }
+
+        if (((pucData[lBit >> 3] >> (7 - (lBit & 7))) & 1) != ucBit)
+        {
+            break;
+        }
+        lBit++;
+    }
+
+    *pucBit = ucBit;
+    return lBit - lStart;
+}
+
+
+//*****************************************************************************
+//
+// Draws one row of a 1bpp bitmap as runs of a single color.  Bits set to 1
+// are drawn in usFore; bits set to 0 in usBack, or not at all when
+// bTransparent is set, in which case each run of set bits becomes one span.
+//
+//*****************************************************************************
+static void Crystalfontz128x128_MonoRow(int16_t lX, int16_t lY, int16_t lX0,
+                                        int16_t lCount,
+                                        const uint8_t *pucData,
+                                        uint16_t usFore, uint16_t usBack,
+                                        bool bTransparent)
+{
+    int16_t lBit = lX0;
+    int16_t lEnd = lX0 + lCount;
+    int16_t lRun;
+    uint8_t ucBit;
+
+#if LCD_BUFFERED_DRAWING
+    if (Crystalfontz128x128_InBuffer(lY))
+    {
+        while (lBit < lEnd)
+        {
+            lRun = Crystalfontz128x128_MonoRun(pucData, lBit, lEnd, &ucBit);
+            if (ucBit || !bTransparent)
+            {
+                Crystalfontz128x128_BufferFill(&Lcd_FrameBuffer, lX, lY,
+                                               lX + lRun - 1, lY,
+                                               ucBit ? usFore : usBack);
+            }
+            lX += lRun;
+            lBit += lRun;
+        }
+        Crystalfontz128x128_AddDirty(lX - lCount, lY, lX - 1, lY);
+        return;
+    }
+    if (Lcd_Stripping)
+        return;
+#endif
+
+    if (bTransparent)
+    {
+        while (lBit < lEnd)
+        {
+            lRun = Crystalfontz128x128_MonoRun(pucData, lBit, lEnd, &ucBit);
+            if (ucBit)
+            {
+                Crystalfontz128x128_FillDirect(lX, lY, lX + lRun - 1, lY,
+                                               usFore);
+            }
+            lX += lRun;
+            lBit += lRun;
+        }
+        return;
+    }
+
+#if LCD_COLOR_DEPTH == 12
+    //
+    // A run of odd length would split a packed pair, so opaque rows are
+    // expanded into a line buffer and packed as a whole.
+    //
+    {
+        uint16_t *pusLine = Lcd_LineBuffer[Lcd_LineBufferIndex];
+        uint16_t *pusOut = pusLine;
+        uint16_t usWire;
+
+        Lcd_LineBufferIndex ^= 1;
+        while (lBit < lEnd)
+        {
+            lRun = Crystalfontz128x128_MonoRun(pucData, lBit, lEnd, &ucBit);
+            usWire = ucBit ? usFore : usBack;
+            usWire = (usWire >> 8) | (usWire << 8);
+            lBit += lRun;
+            while (lRun--)
+                *pusOut++ = usWire;
+        }
+
+        Crystalfontz128x128_SetDrawFrame(lX, lY, lX + lCount - 1, lY);
+        HAL_LCD_writeCommand(CM_RAMWR);
+        Crystalfontz128x128_WriteLine((const uint8_t *)pusLine, (uint32_t)lCount * 2);
+        return;
+    }
+#endif
+
+    //
+    // Opaque rows are one window, with every run sent as a repeated color.
+    //
+    Crystalfontz128x128_SetDrawFrame(lX, lY, lX + lCount - 1, lY);
+    HAL_LCD_writeCommand(CM_RAMWR);
+    while (lBit < lEnd)
+    {
+        lRun = Crystalfontz128x128_MonoRun(pucData, lBit, lEnd, &ucBit);
+        HAL_LCD_writeRepeat16(ucBit ? usFore : usBack, lRun);
+        lBit += lRun;
+    }
+}
+
+//*****************************************************************************
+//
+//! Initializes the display driver.
+//!
+//! This function initializes the ST7735 display controller on the panel,
+//! preparing it to display data.
+//!
+//! \return None.
+//
+//*****************************************************************************
+void Crystalfontz128x128_Init(void)
+{
+    HAL_LCD_PortInit();
+    HAL_LCD_SpiInit();
+    HAL_LCD_DmaInit();
+
+    //
+    // The same waits as Crystalfontz128x128_InitAsync(), in microseconds.
+    //
+    GPIO_setOutputLowOnPin(LCD_RST_PORT, LCD_RST_PIN);
+    HAL_LCD_delay(LCD_INIT_RESET_PULSE_US);
+    GPIO_setOutputHighOnPin(LCD_RST_PORT, LCD_RST_PIN);
+    HAL_LCD_delay(LCD_INIT_RESET_WAIT_US);
+
+    //
+    // The reset put the panel's address window back to its default.
+    //
+    Crystalfontz128x128_InvalidateDrawFrame();
+
+    HAL_LCD_writeCommand(CM_SLPOUT);
+    HAL_LCD_delay(LCD_INIT_SLEEP_OUT_WAIT_US);
+
+    Crystalfontz128x128_Configure();
+    HAL_LCD_waitDMA();
+
+    HAL_LCD_delay(LCD_INIT_DISPLAY_ON_WAIT_US);
+    HAL_LCD_writeCommand(CM_DISPON);
+
+    Lcd_InitStep = LCD_INIT_DONE;
+}
+
+
+//*****************************************************************************
+//
+// Advances Crystalfontz128x128_InitAsync() by one step.  Runs from the
+// software timer or DMA completion interrupt.
+//
+//*****************************************************************************
+static void Crystalfontz128x128_InitNext(void)
+{
+    switch (Lcd_InitStep)
+    {
+    case LCD_INIT_RESET:
+        GPIO_setOutputHighOnPin(LCD_RST_PORT, LCD_RST_PIN);
+        Crystalfontz128x128_InvalidateDrawFrame();
+        Lcd_InitStep = LCD_INIT_SLEEP_OUT;
+        HAL_LCD_scheduleCallback(LCD_INIT_RESET_WAIT_US, Crystalfontz128x128_InitNext);
+        break;
+
+    case LCD_INIT_SLEEP_OUT:
+        HAL_LCD_writeCommand(CM_SLPOUT);
+        Lcd_InitStep = LCD_INIT_CONFIGURE;
+        HAL_LCD_scheduleCallback(LCD_INIT_SLEEP_OUT_WAIT_US, Crystalfontz128x128_InitNext);
+        break;
+
+    case LCD_INIT_CONFIGURE:
+        Crystalfontz128x128_Configure();
+        Lcd_InitStep = LCD_INIT_CONFIGURED;
+        HAL_LCD_whenDMADone(Crystalfontz128x128_InitNext);
+        break;
+
+    case LCD_INIT_CONFIGURED:
+        //
+        // Wait from the timer rather than in the DMA interrupt, which would
+        // hold back every interrupt at its level for as long.
+        //
+        Lcd_InitStep = LCD_INIT_DISPLAY_ON;
+        HAL_LCD_scheduleCallback(LCD_INIT_DISPLAY_ON_WAIT_US, Crystalfontz128x128_InitNext);
+        break;
+
+    case LCD_INIT_DISPLAY_ON:
+        HAL_LCD_writeCommand(CM_DISPON);
+        Lcd_InitStep = LCD_INIT_DONE;
+        SleepManager_unblockLPM3(SLEEP_BLOCKER_LCD);
+        if (Lcd_InitDone)
+        {
+            Lcd_InitDone();
+        }
+        break;
+
+    default:
+        break;
+    }
+}
+
+
+//*****************************************************************************
+//
+//! Initializes the display driver without waiting.
+//!
+//! \param pfnDone is called, from an interrupt, once the display is ready;
+//! it can be NULL.  Posting an event to the application's queue from it is
+//! the usual way to hand the display over to main.
+//!
+//! This function starts the same sequence as Crystalfontz128x128_Init() and
+//! returns; the rest runs from the software timer and DMA interrupts, which
+//! must be initialized first.  It waits for as long as the ST7735 datasheet
+//! asks after the reset and SLPOUT, about a quarter of a second in all,
+//! during which the application keeps running.  Nothing may be drawn until
+//! Crystalfontz128x128_IsReady() returns true.  LPM3 is blocked until then,
+//! since the SPI and DMA need SMCLK.
+//!
+//! \return None.
+//
+//*****************************************************************************
+void Crystalfontz128x128_InitAsync(void (*pfnDone)(void))
+{
+    Lcd_InitDone = pfnDone;
+    Lcd_InitStep = LCD_INIT_RESET;
+    SleepManager_blockLPM3(SLEEP_BLOCKER_LCD);
+
+    HAL_LCD_PortInit();
+    HAL_LCD_SpiInit();
+    HAL_LCD_DmaInit();
+
+    GPIO_setOutputLowOnPin(LCD_RST_PORT, LCD_RST_PIN);
+    HAL_LCD_scheduleCallback(LCD_INIT_RESET_PULSE_US, Crystalfontz128x128_InitNext);
+}
+
+
+//*****************************************************************************
+//
+//! Returns true once Crystalfontz128x128_Init() or
+//! Crystalfontz128x128_InitAsync() has finished.
+//
+//*****************************************************************************
+bool Crystalfontz128x128_IsReady(void)
+{
+    return Lcd_InitStep == LCD_INIT_DONE;
+}
+
+
+//*****************************************************************************
+//
+// Sends the configuration that follows SLPOUT and starts clearing the panel
+// to white.  The clear is still in progress on return when it goes through
+// the DMA.
+//
+//*****************************************************************************
+static void Crystalfontz128x128_Configure(void)
+{
+    HAL_LCD_writeCommand(CM_GAMSET);
+    HAL_LCD_writeData(0x04);
+
+    HAL_LCD_writeCommand(CM_SETPWCTR);
+    HAL_LCD_writeData(0x0A);
+    HAL_LCD_writeData(0x14);
+
+    HAL_LCD_writeCommand(CM_SETSTBA);
+    HAL_LCD_writeData(0x0A);
+    HAL_LCD_writeData(0x00);
+
+    HAL_LCD_writeCommand(CM_COLMOD);
+#if LCD_COLOR_DEPTH == 12
+    HAL_LCD_writeData(0x03);
+#else
+    HAL_LCD_writeData(0x05);
+#endif
+    HAL_LCD_delay(10);
+
+    //
+    // The address window offsets of SetDrawFrame() follow the orientation,
+    // so MADCTL has to match it for the clear below to cover the screen.
+    //
+    Crystalfontz128x128_SetOrientation(LCD_CURRENT_ORIENTATION);
+
+    HAL_LCD_writeCommand(CM_NORON);
+
+    Crystalfontz128x128_SetDrawFrame(0, 0, 127, 127);
+    HAL_LCD_writeCommand(CM_RAMWR);
+    Crystalfontz128x128_WriteColor(0xFFFF, 16384);
+}
+
+
+//*****************************************************************************
+//
+//! Forgets the address window cached by Crystalfontz128x128_SetDrawFrame().
+//!
+//! Call this after sending commands to the panel other than through this
+//! driver, or after resetting it, so the next drawing operation reprograms
+//! the window.
+//!
+//! \return None.
+//
+//*****************************************************************************
+void Crystalfontz128x128_InvalidateDrawFrame(void)
+{
+    Lcd_FrameValid = false;
+    Lcd_CursorValid = false;
+}
+
+
+//*****************************************************************************
+//
+//! Sets the address window for the next RAMWR.
+//!
+//! \param x0, y0, x1, y1 are the inclusive screen coordinates of the window.
+//!
+//! CASET and RASET are only sent when the column or row range differs from
+//! the one last sent.
+//!
+//! \return None.
+//
+//*****************************************************************************
+void Crystalfontz128x128_SetDrawFrame(uint16_t x0, uint16_t y0, uint16_t x1, uint16_t y1)
+{
+    bool bValid = Lcd_FrameValid;
+
+    //
+    // Whatever comes next, it is not a continuation of PixelDraw's RAMWR.
+    //
+    Lcd_CursorValid = false;
+
+    x0 += LCD_PANEL_OFFSET_X;
+    y0 += LCD_PANEL_OFFSET_Y;
+    x1 += LCD_PANEL_OFFSET_X;
+    y1 += LCD_PANEL_OFFSET_Y;
+
+    if (!bValid || (x0 != Lcd_FrameX0) || (x1 != Lcd_FrameX1))
+    {
+        HAL_LCD_writeCommand(CM_CASET);
+        HAL_LCD_writeData((uint8_t)(x0 >> 8));
+        HAL_LCD_writeData((uint8_t)(x0));
+        HAL_LCD_writeData((uint8_t)(x1 >> 8));
+        HAL_LCD_writeData((uint8_t)(x1));
+        Lcd_FrameX0 = x0;
+        Lcd_FrameX1 = x1;
+    }
+
+    if (!bValid || (y0 != Lcd_FrameY0) || (y1 != Lcd_FrameY1))
+    {
+        HAL_LCD_writeCommand(CM_RASET);
+        HAL_LCD_writeData((uint8_t)(y0 >> 8));
+        HAL_LCD_writeData((uint8_t)(y0));
+        HAL_LCD_writeData((uint8_t)(y1 >> 8));
+        HAL_LCD_writeData((uint8_t)(y1));
+        Lcd_FrameY0 = y0;
+        Lcd_FrameY1 = y1;
+    }
+
+    Lcd_FrameValid = true;
+}
+
+
+//*****************************************************************************
+//
+//! Sets the LCD Orientation.
+//!
+//! \param orientation is the desired orientation for the LCD. Valid values are:
+//!           - \b LCD_ORIENTATION_UP,
+//!           - \b LCD_ORIENTATION_LEFT,
+//!           - \b LCD_ORIENTATION_DOWN,
+//!           - \b LCD_ORIENTATION_RIGHT,
+//!
+//! This function sets the orientation of the LCD.  When it is fixed with
+//! LCD_FIXED_ORIENTATION, \e orientation is ignored and the fixed one is set
+//! again.
+//!
+//! \return None.
+//
+//*****************************************************************************
+void Crystalfontz128x128_SetOrientation(uint8_t orientation)
+{
+    Crystalfontz128x128_InvalidateDrawFrame();
+
+#if LCD_FIXED_ORIENTATION == LCD_ORIENTATION_RUNTIME
+    Lcd_Orientation = orientation;
+#else
+    (void)orientation;
+#endif
+    HAL_LCD_writeCommand(CM_MADCTL);
+    switch (LCD_CURRENT_ORIENTATION) {
+        case LCD_ORIENTATION_UP:
+            HAL_LCD_writeData(CM_MADCTL_MX | CM_MADCTL_MY | CM_MADCTL_BGR);
+            break;
+        case LCD_ORIENTATION_LEFT:
+            HAL_LCD_writeData(CM_MADCTL_MY | CM_MADCTL_MV | CM_MADCTL_BGR);
+            break;
+        case LCD_ORIENTATION_DOWN:
+            HAL_LCD_writeData(CM_MADCTL_BGR);
+            break;
+        case LCD_ORIENTATION_RIGHT:
+            HAL_LCD_writeData(CM_MADCTL_MX | CM_MADCTL_MV | CM_MADCTL_BGR);
+            break;
+    }
+}
+
+
+//*****************************************************************************
+//
+// The panel's frame memory is 132 rows along its scan direction, of which
+// rows 1 to 128 are visible.  LCD_ORIENTATION_UP and LCD_ORIENTATION_LEFT
+// address them bottom to top, the other two top to bottom; the scan direction
+// is the screen's y axis for UP and DOWN and its x axis for LEFT and RIGHT.
+//
+//*****************************************************************************
+static bool Crystalfontz128x128_ScanReversed(void)
+{
+    return (LCD_CURRENT_ORIENTATION == LCD_ORIENTATION_UP) ||
+           (LCD_CURRENT_ORIENTATION == LCD_ORIENTATION_LEFT);
+}
+
+
+//*****************************************************************************
+//
+//! Defines the area moved by hardware scrolling.
+//!
+//! \param top is the number of fixed lines before the scrolling area.
+//! \param height is the number of lines in the scrolling area.
+//! \param bottom is the number of fixed lines after it.
+//!
+//! Lines are counted along the panel's scan direction, which is the y axis
+//! for LCD_ORIENTATION_UP and LCD_ORIENTATION_DOWN and the x axis for
+//! LCD_ORIENTATION_LEFT and LCD_ORIENTATION_RIGHT.  top, height and bottom
+//! must add up to 128.  The mapping depends on the orientation, so call this
+//! again after Crystalfontz128x128_SetOrientation().  The scrolling area
+//! starts out unscrolled.
+//!
+//! Scrolling only changes which lines are shown where; drawing coordinates
+//! keep addressing the same frame memory.
+//!
+//! \return None.
+//
+//*****************************************************************************
+void Crystalfontz128x128_SetScrollArea(uint16_t top, uint16_t height, uint16_t bottom)
+{
+    uint16_t tfa, bfa;
+
+    Lcd_ScrollTop = top;
+    Lcd_ScrollHeight = height;
+    Lcd_ScrollBottom = bottom;
+
+    //
+    // The first hidden line belongs to the fixed area at the start of frame
+    // memory and the three hidden lines after the screen to the one at the
+    // end.
+    //
+    if (Crystalfontz128x128_ScanReversed())
+    {
+        tfa = bottom + 1;
+        bfa = top + 3;
+    }
+    else
+    {
+        tfa = top + 1;
+        bfa = bottom + 3;
+    }
+
+    Lcd_CursorValid = false;
+    HAL_LCD_writeCommand(CM_VSCRDEF);
+    HAL_LCD_writeData((uint8_t)(tfa >> 8));
+    HAL_LCD_writeData((uint8_t)(tfa));
+    HAL_LCD_writeData((uint8_t)(height >> 8));
+    HAL_LCD_writeData((uint8_t)(height));
+    HAL_LCD_writeData((uint8_t)(bfa >> 8));
+    HAL_LCD_writeData((uint8_t)(bfa));
+
+    Crystalfontz128x128_ScrollTo(top);
+}
+
+
+//*****************************************************************************
+//
+//! Scrolls the scrolling area.
+//!
+//! \param line is the line, in drawing coordinates along the scan direction,
+//! to show at the start of the scrolling area.  It must be within the area
+//! set by Crystalfontz128x128_SetScrollArea(); the lines after it follow,
+//! wrapping around to the start of the area.
+//!
+//! For a scrolling log, draw each new line of text over the oldest one and
+//! scroll to the line after it.  While buffering is on, pending changes are
+//! flushed first so the new text is on the panel when it scrolls into view.
+//!
+//! \return None.
+//
+//*****************************************************************************
+void Crystalfontz128x128_ScrollTo(uint16_t line)
+{
+    uint16_t offset = line - Lcd_ScrollTop;
+    uint16_t ssa;
+
+    if (Lcd_ScrollHeight == 0)
+        return;
+
+#if LCD_BUFFERED_DRAWING
+    if (Lcd_Buffered)
+    {
+        Crystalfontz128x128_FlushDirty();
+    }
+#endif
+
+    if (Crystalfontz128x128_ScanReversed())
+    {
+        //
+        // Frame memory runs the other way, so the area's first line on
+        // screen is the last one the panel scans.
+        //
+        ssa = Lcd_ScrollBottom + 1 +
+              (Lcd_ScrollHeight - offset) % Lcd_ScrollHeight;
+    }
+    else
+    {
+        ssa = line + 1;
+    }
+
+    Lcd_CursorValid = false;
+    HAL_LCD_writeCommand(CM_VSCSAD);
+    HAL_LCD_writeData((uint8_t)(ssa >> 8));
+    HAL_LCD_writeData((uint8_t)(ssa));
+}
 
-uint8_t Lcd_Orientation;
-uint16_t Lcd_ScreenWidth, Lcd_ScreenHeigth;
-uint8_t Lcd_PenSolid, Lcd_FontSolid, Lcd_FlagRead;
-uint16_t Lcd_TouchTrim;
 
 //*****************************************************************************
 //
-//! Initializes the display driver.
+//! Turns the local framebuffer on or off.
 //!
-//! This function initializes the ST7735 display controller on the panel,
-//! preparing it to display data.
+//! \param bBuffered selects buffered drawing.
+//!
+//! While buffering is on, the primitives render the rows held by the
+//! framebuffer (LCD_FRAMEBUFFER_ROWS of them, starting at the row set by
+//! Crystalfontz128x128_SetBufferOrigin()) into SRAM, and Graphics_flushBuffer()
+//! sends only the regions that changed.  Turning buffering on starts with a
+//! cleared buffer, so the buffered rows should be redrawn before the next
+//! flush.  Turning it off flushes pending changes first.
+//!
+//! This function does nothing when LCD_FRAMEBUFFER_ROWS is 0.
 //!
 //! \return None.
 //
 //*****************************************************************************
-void Crystalfontz128x128_Init(void)
+void Crystalfontz128x128_SetBuffered(bool bBuffered)
 {
-    HAL_LCD_PortInit();
-    HAL_LCD_SpiInit();
+#if LCD_FRAMEBUFFER_ROWS > 0
+    if (Lcd_Buffered)
+    {
+        Crystalfontz128x128_FlushDirty();
+        HAL_LCD_waitDMA();
+    }
 
-    GPIO_setOutputLowOnPin(LCD_RST_PORT, LCD_RST_PIN);
-    HAL_LCD_delay(50);
-    GPIO_setOutputHighOnPin(LCD_RST_PORT, LCD_RST_PIN);
-    HAL_LCD_delay(120);
+    Lcd_Buffered = bBuffered;
+    if (bBuffered)
+    {
+        Crystalfontz128x128_ResetBuffer();
+    }
+#endif
+}
 
-    HAL_LCD_writeCommand(CM_SLPOUT);
-    HAL_LCD_delay(200);
 
-    HAL_LCD_writeCommand(CM_GAMSET);
-    HAL_LCD_writeData(0x04);
+//*****************************************************************************
+//
+//! Moves the rows held by the local framebuffer.
+//!
+//! \param y is the first screen row to hold.  It is clamped so that all of
+//! the LCD_FRAMEBUFFER_ROWS rows are on screen.
+//!
+//! Only useful when the framebuffer is smaller than the screen.  Pending
+//! changes are flushed and the buffer starts over cleared, as in
+//! Crystalfontz128x128_SetBuffered().
+//!
+//! \return None.
+//
+//*****************************************************************************
+void Crystalfontz128x128_SetBufferOrigin(int16_t y)
+{
+#if LCD_FRAMEBUFFER_ROWS > 0
+    if (y > LCD_VERTICAL_MAX - LCD_FRAMEBUFFER_ROWS)
+        y = LCD_VERTICAL_MAX - LCD_FRAMEBUFFER_ROWS;
+    if (y < 0)
+        y = 0;
 
-    HAL_LCD_writeCommand(CM_SETPWCTR);
-    HAL_LCD_writeData(0x0A);
-    HAL_LCD_writeData(0x14);
+    if (Lcd_Buffered)
+    {
+        Crystalfontz128x128_FlushDirty();
+        HAL_LCD_waitDMA();
+    }
 
-    HAL_LCD_writeCommand(CM_SETSTBA);
-    HAL_LCD_writeData(0x0A);
-    HAL_LCD_writeData(0x00);
+    Lcd_FrameBuffer.sYOrigin = y;
+    if (Lcd_Buffered)
+    {
+        Crystalfontz128x128_ResetBuffer();
+    }
+#endif
+}
 
-    HAL_LCD_writeCommand(CM_COLMOD);
-    HAL_LCD_writeData(0x05);
-    HAL_LCD_delay(10);
 
-    HAL_LCD_writeCommand(CM_MADCTL);
-    HAL_LCD_writeData(CM_MADCTL_BGR);
+//*****************************************************************************
+//
+//! Draws a whole frame one strip at a time.
+//!
+//! \param psContext is the grlib context to draw with, on this driver.
+//! \param pfnDraw draws the scene.  It is called once per strip, with
+//! psContext clipped to the strip, and should draw everything that may
+//! cover those rows.
+//! \param pvArg is passed to pfnDraw.
+//!
+//! The screen is cut into strips of LCD_STRIP_ROWS full-width rows.  Each is
+//! cleared to the context's background, drawn into SRAM, and then sent with
+//! a single RAMWR through the DMA while the next one is drawn into the other
+//! strip buffer.  Every pixel goes over the wire just once per frame, however
+//! many times the scene draws over it, for 2 * LCD_STRIP_ROWS * 256 bytes of
+//! SRAM.  The function returns while the last strip is still being sent;
+//! Graphics_flushBuffer() waits for it.
+//!
+//! Anything the framebuffer of Crystalfontz128x128_SetBuffered() had pending
+//! is flushed first.  Its rows no longer match the panel afterwards.
+//!
+//! This function does nothing when LCD_STRIP_ROWS is 0.
+//!
+//! \return None.
+//
+//*****************************************************************************
+void Crystalfontz128x128_RenderStrips(Graphics_Context *psContext,
+                                      void (*pfnDraw)(Graphics_Context *psContext,
+                                                      void *pvArg),
+                                      void *pvArg)
+{
+#if LCD_STRIP_ROWS > 0
+    Crystalfontz128x128_Buffer sSaved = Lcd_FrameBuffer;
+    Graphics_Rectangle sClip = psContext->clipRegion;
+    bool bBuffered = Lcd_Buffered;
+    uint8_t ucStrip = 0;
+    int16_t y;
 
-    HAL_LCD_writeCommand(CM_NORON);
+    if (bBuffered)
+    {
+        Crystalfontz128x128_FlushDirty();
+    }
 
-    Lcd_ScreenWidth  = LCD_VERTICAL_MAX;
-    Lcd_ScreenHeigth = LCD_HORIZONTAL_MAX;
-    Lcd_PenSolid  = 0;
-    Lcd_FontSolid = 1;
-    Lcd_FlagRead  = 0;
-    Lcd_TouchTrim = 0;
+    Lcd_Buffered = true;
+    Lcd_Stripping = true;
 
-    Crystalfontz128x128_SetDrawFrame(0, 0, 127, 127);
-    HAL_LCD_writeCommand(CM_RAMWR);
-    int i;
-    for (i = 0; i < 16384; i++)
+    for (y = 0; y < LCD_VERTICAL_MAX; y += LCD_STRIP_ROWS)
     {
-        HAL_LCD_writeData(0xFF);
-        HAL_LCD_writeData(0xFF);
+        int16_t sRows = (LCD_VERTICAL_MAX - y < LCD_STRIP_ROWS) ?
+                        LCD_VERTICAL_MAX - y : LCD_STRIP_ROWS;
+        Graphics_Rectangle sStrip = { 0, y, LCD_HORIZONTAL_MAX - 1, y + sRows - 1 };
+
+        //
+        // Only one transfer is in flight at a time, so the strip sent from
+        // this buffer two strips ago is already done.
+        //
+        Lcd_FrameBuffer.pusPixels = Lcd_StripPixels[ucStrip];
+        Lcd_FrameBuffer.sYOrigin = y;
+        Lcd_FrameBuffer.sRows = sRows;
+        Crystalfontz128x128_BufferFill(&Lcd_FrameBuffer, sStrip.sXMin, sStrip.sYMin,
+                                       sStrip.sXMax, sStrip.sYMax,
+                                       psContext->background);
+
+        Graphics_setClipRegion(psContext, &sStrip);
+        pfnDraw(psContext, pvArg);
+
+        //
+        // The commands wait for the previous strip to be done; then this one
+        // goes out while the next is drawn.
+        //
+        Crystalfontz128x128_SetDrawFrame(sStrip.sXMin, sStrip.sYMin,
+                                         sStrip.sXMax, sStrip.sYMax);
+        HAL_LCD_writeCommand(CM_RAMWR);
+        Crystalfontz128x128_WriteLine((const uint8_t *)Lcd_StripPixels[ucStrip],
+                                      (uint32_t)sRows * LCD_HORIZONTAL_MAX * 2);
+
+        ucStrip ^= 1;
     }
 
-    HAL_LCD_delay(10);
-    HAL_LCD_writeCommand(CM_DISPON);
+    Graphics_setClipRegion(psContext, &sClip);
+    Lcd_Stripping = false;
+    Lcd_Buffered = bBuffered;
+    Lcd_FrameBuffer = sSaved;
+#endif
 }
 
 
-void Crystalfontz128x128_SetDrawFrame(uint16_t x0, uint16_t y0, uint16_t x1, uint16_t y1)
+//*****************************************************************************
+//
+//! Empties the image palette cache.
+//!
+//! Palettes are cached by address.  Call this after changing the contents of
+//! a palette in RAM that has already been used to draw an image.
+//!
+//! \return None.
+//
+//*****************************************************************************
+void Crystalfontz128x128_InvalidatePaletteCache(void)
 {
-    switch (Lcd_Orientation) {
-        case 0:
-            x0 += 2;
-            y0 += 3;
-            x1 += 2;
-            y1 += 3;
-            break;
-        case 1:
-            x0 += 3;
-            y0 += 2;
-            x1 += 3;
-            y1 += 2;
-            break;
-        case 2:
-            x0 += 2;
-            y0 += 1;
-            x1 += 2;
-            y1 += 1;
-            break;
-        case 3:
-            x0 += 1;
-            y0 += 2;
-            x1 += 1;
-            y1 += 2;
-            break;
-        default:
-            break;
+#if LCD_PALETTE_CACHED
+    uint8_t i;
+
+    for (i = 0; i < LCD_PALETTE_CACHE_ENTRIES; i++)
+    {
+        Lcd_PaletteCache[i].pulPalette = 0;
     }
+#endif
+}
 
-    HAL_LCD_writeCommand(CM_CASET);
-    HAL_LCD_writeData((uint8_t)(x0 >> 8));
-    HAL_LCD_writeData((uint8_t)(x0));
-    HAL_LCD_writeData((uint8_t)(x1 >> 8));
-    HAL_LCD_writeData((uint8_t)(x1));
 
-    HAL_LCD_writeCommand(CM_RASET);
-    HAL_LCD_writeData((uint8_t)(y0 >> 8));
-    HAL_LCD_writeData((uint8_t)(y0));
-    HAL_LCD_writeData((uint8_t)(y1 >> 8));
-    HAL_LCD_writeData((uint8_t)(y1));
+//*****************************************************************************
+//
+// Sends rows y0 to y1 of a native image placed at (x, y) straight to the
+// panel, with a single address window.
+//
+//*****************************************************************************
+static void Crystalfontz128x128_DrawNativeDirect(int16_t x, int16_t y,
+                                                 int16_t w,
+                                                 int16_t y0, int16_t y1,
+                                                 const uint8_t *pucImage)
+{
+    Crystalfontz128x128_SetDrawFrame(x, y0, x + w - 1, y1);
+    HAL_LCD_writeCommand(CM_RAMWR);
+    Crystalfontz128x128_WriteLine(pucImage + (uint32_t)(y0 - y) * w * 2,
+                                  (uint32_t)(y1 - y0 + 1) * w * 2);
 }
 
 
 //*****************************************************************************
 //
-//! Sets the LCD Orientation.
+//! Draws an image stored in the panel's native format.
 //!
-//! \param orientation is the desired orientation for the LCD. Valid values are:
-//!           - \b LCD_ORIENTATION_UP,
-//!           - \b LCD_ORIENTATION_LEFT,
-//!           - \b LCD_ORIENTATION_DOWN,
-//!           - \b LCD_ORIENTATION_RIGHT,
+//! \param x, y are the screen coordinates of the top left corner.
+//! \param w, h are the width and height of the image in pixels.
+//! \param pucImage points to the image, in the format described with
+//! CRYSTALFONTZ_NATIVE_PIXEL().
 //!
-//! This function sets the orientation of the LCD
+//! The whole rectangle is sent with one address window and, when large
+//! enough, one DMA transfer that reads the image where it is.  The transfer
+//! may still be running when this function returns, so an image in RAM must
+//! not be changed before the next drawing call or Graphics_flushBuffer().
+//! The image is assumed to be within the extents of the display.  While
+//! buffering is on, the rows held by the framebuffer are copied there
+//! instead.
 //!
 //! \return None.
 //
 //*****************************************************************************
-void Crystalfontz128x128_SetOrientation(uint8_t orientation)
+void Crystalfontz128x128_DrawNativeImage(int16_t x, int16_t y,
+                                         int16_t w, int16_t h,
+                                         const uint8_t *pucImage)
 {
-    Lcd_Orientation = orientation;
-    HAL_LCD_writeCommand(CM_MADCTL);
-    switch (Lcd_Orientation) {
-        case LCD_ORIENTATION_UP:
-            HAL_LCD_writeData(CM_MADCTL_MX | CM_MADCTL_MY | CM_MADCTL_BGR);
-            break;
-        case LCD_ORIENTATION_LEFT:
-            HAL_LCD_writeData(CM_MADCTL_MY | CM_MADCTL_MV | CM_MADCTL_BGR);
-            break;
-        case LCD_ORIENTATION_DOWN:
-            HAL_LCD_writeData(CM_MADCTL_BGR);
-            break;
-        case LCD_ORIENTATION_RIGHT:
-            HAL_LCD_writeData(CM_MADCTL_MX | CM_MADCTL_MV | CM_MADCTL_BGR);
-            break;
+    int16_t y1 = y + h - 1;
+
+    if ((w <= 0) || (h <= 0))
+        return;
+
+#if LCD_BUFFERED_DRAWING
+    if (Lcd_Buffered)
+    {
+        int16_t sTop = Lcd_FrameBuffer.sYOrigin;
+        int16_t sBottom = sTop + Lcd_FrameBuffer.sRows - 1;
+        int16_t sRow;
+
+        if ((y < sTop) && !Lcd_Stripping)
+        {
+            Crystalfontz128x128_DrawNativeDirect(x, y, w, y,
+                                                 (y1 < sTop) ? y1 : sTop - 1,
+                                                 pucImage);
+        }
+        if ((y1 > sBottom) && !Lcd_Stripping)
+        {
+            Crystalfontz128x128_DrawNativeDirect(x, y, w,
+                                                 (y > sBottom) ? y : sBottom + 1,
+                                                 y1, pucImage);
+        }
+        if ((y <= sBottom) && (y1 >= sTop))
+        {
+            int16_t sFirst = (y < sTop) ? sTop : y;
+            int16_t sLast = (y1 > sBottom) ? sBottom : y1;
+
+            for (sRow = sFirst; sRow <= sLast; sRow++)
+            {
+                Crystalfontz128x128_BufferWrite(&Lcd_FrameBuffer, x, sRow,
+                                                pucImage + (uint32_t)(sRow - y) * w * 2,
+                                                w * 2);
+            }
+            Crystalfontz128x128_AddDirty(x, sFirst, x + w - 1, sLast);
+        }
+        return;
+    }
+#endif
+
+    Crystalfontz128x128_DrawNativeDirect(x, y, w, y, y1, pucImage);
+}
+
+
+//*****************************************************************************
+//
+//! Draws a 1bpp bitmap, such as a glyph.
+//!
+//! \param x, y are the screen coordinates of the top left corner.
+//! \param w, h are the width and height of the bitmap in pixels.
+//! \param pucBitmap points to the bitmap: rows top to bottom, each padded to
+//! a whole number of bytes, with the most significant bit on the left.
+//! \param ulForeground is the color of the set bits, as returned by the
+//! driver's ColorTranslate.
+//! \param ulBackground is the color of the clear bits.
+//! \param bOpaque selects whether clear bits are drawn at all.
+//!
+//! Each row is drawn as runs of a single color.  With bOpaque false, every
+//! run of set bits is one horizontal span, rather than one PixelDraw per
+//! pixel.  The bitmap is assumed to be within the extents of the display.
+//!
+//! \return None.
+//
+//*****************************************************************************
+void Crystalfontz128x128_DrawMonoBitmap(int16_t x, int16_t y,
+                                        int16_t w, int16_t h,
+                                        const uint8_t *pucBitmap,
+                                        uint16_t ulForeground,
+                                        uint16_t ulBackground,
+                                        bool bOpaque)
+{
+    int16_t lStride = (w + 7) / 8;
+
+    if (w <= 0)
+        return;
+
+    while (h-- > 0)
+    {
+        Crystalfontz128x128_MonoRow(x, y++, 0, w, pucBitmap,
+                                    ulForeground, ulBackground, !bOpaque);
+        pucBitmap += lStride;
     }
 }
 
@@ -213,15 +1546,50 @@ static void Crystalfontz128x128_PixelDraw(const Graphics_Display *pDisplay,
                                           int16_t lY,
                                           uint16_t ulValue)
 {
+#if LCD_BUFFERED_DRAWING
+    if(Crystalfontz128x128_InBuffer(lY))
+    {
+        Crystalfontz128x128_BufferFill(&Lcd_FrameBuffer, lX, lY, lX, lY, ulValue);
+        Crystalfontz128x128_AddDirty(lX, lY, lX, lY);
+        return;
+    }
+    if (Lcd_Stripping)
+        return;
+#endif
 
-    Crystalfontz128x128_SetDrawFrame(lX,lY,lX,lY);
+    //
+    // grlib draws lines and circles one pixel at a time.  The window is left
+    // open to the end of the row, so a pixel just right of the previous one
+    // is written without any command.
+    //
+    if(!Lcd_CursorValid || (lX != Lcd_CursorX) || (lY != Lcd_CursorY))
+    {
+        Crystalfontz128x128_SetDrawFrame(lX,lY,LCD_HORIZONTAL_MAX-1,lY);
+        HAL_LCD_writeCommand(CM_RAMWR);
+    }
 
     //
     // Write the pixel value.
     //
-    HAL_LCD_writeCommand(CM_RAMWR);
+#if LCD_COLOR_DEPTH == 12
+    //
+    // A lone 12-bit pixel takes two bytes, the last four bits of which are
+    // dropped, so the write pointer cannot be left where the next pixel goes.
+    //
+    {
+        uint16_t us444 = Crystalfontz128x128_To444(ulValue);
+
+        HAL_LCD_writeData(us444 >> 4);
+        HAL_LCD_writeData(us444 << 4);
+        return;
+    }
+#endif
     HAL_LCD_writeData(ulValue>>8);
     HAL_LCD_writeData(ulValue);
+
+    Lcd_CursorX = lX + 1;
+    Lcd_CursorY = lY;
+    Lcd_CursorValid = (Lcd_CursorX < LCD_HORIZONTAL_MAX);
 }
 
 
@@ -236,7 +1604,8 @@ static void Crystalfontz128x128_PixelDraw(const Graphics_Display *pDisplay,
 //! \param lX0 is sub-pixel offset within the pixel data, which is valid for 1
 //! or 4 bit per pixel formats.
 //! \param lCount is the number of pixels to draw.
-//! \param lBPP is the number of bits per pixel; must be 1, 4, or 8.
+//! \param lBPP is the number of bits per pixel; must be 1, 4, 8 or 16, and in
+//! LCD_IMAGE_FORMATS.
 //! \param pucData is a pointer to the pixel data.  For 1 and 4 bit per pixel
 //! formats, the most significant bit(s) represent the left-most pixel.
 //! \param pucPalette is a pointer to the palette used to draw the pixels.
@@ -259,13 +1628,22 @@ static void Crystalfontz128x128_PixelDrawMultiple(const Graphics_Display *pDispl
                                                   const uint8_t *pucData,
                                                   const uint32_t *pucPalette)
 {
-    uint16_t Data;
+    uint8_t *pucLine;
+    uint8_t *pucOut;
+    int16_t lPixels;
 
     //
-    // Set the cursor increment to left to right, followed by top to bottom.
+    // The row is decoded into a line buffer in the panel's byte order and
+    // then sent in one go.  Decoding happens before touching the panel so it
+    // overlaps the DMA transfer of the previous row.
     //
-    Crystalfontz128x128_SetDrawFrame(lX,lY,lX+lCount,127);
-    HAL_LCD_writeCommand(CM_RAMWR);
+    if(lCount > LCD_HORIZONTAL_MAX)
+    {
+        lCount = LCD_HORIZONTAL_MAX;
+    }
+    lPixels = lCount;
+    pucLine = (uint8_t *)Lcd_LineBuffer[Lcd_LineBufferIndex];
+    pucOut = pucLine;
 
     //
     // Determine how to interpret the pixel data based on the number of bits
@@ -273,9 +1651,19 @@ static void Crystalfontz128x128_PixelDrawMultiple(const Graphics_Display *pDispl
     //
     switch(lBPP)
     {
+#if LCD_IMAGE_FORMATS & LCD_IMAGE_1BPP
         // The pixel data is in 1 bit per pixel format
         case 1:
         {
+#if LCD_MONO_RUN_LENGTH
+            // Runs of identical bits go out as repeated colors, with no
+            // decoding into the line buffer
+            Crystalfontz128x128_MonoRow(lX, lY, lX0 & 7, lCount, pucData,
+                                        pucPalette[1], pucPalette[0], false);
+            return;
+#else
+            uint16_t Data;
+
             // Loop while there are more pixels to draw
             while(lCount > 0)
             {
@@ -286,10 +1674,9 @@ static void Crystalfontz128x128_PixelDrawMultiple(const Graphics_Display *pDispl
                 for(; (lX0 < 8) && lCount; lX0++, lCount--)
                 {
                     // Draw this pixel in the appropriate color
-                    HAL_LCD_writeData((((uint32_t *)pucPalette)[(Data >>
-                                                             (7 - lX0)) & 1])>>8);
-                    HAL_LCD_writeData(((uint32_t *)pucPalette)[(Data >>
-                                                             (7 - lX0)) & 1]);
+                    uint16_t Color = pucPalette[(Data >> (7 - lX0)) & 1];
+                    *pucOut++ = Color >> 8;
+                    *pucOut++ = Color;
                 }
 
                 // Start at the beginning of the next byte of image data
@@ -298,11 +1685,34 @@ static void Crystalfontz128x128_PixelDrawMultiple(const Graphics_Display *pDispl
             // The image data has been drawn
 
             break;
+#endif
         }
+#endif
 
+#if LCD_IMAGE_FORMATS & LCD_IMAGE_4BPP
         // The pixel data is in 4 bit per pixel format
         case 4:
         {
+            uint16_t Data;
+#if LCD_PALETTE_CACHED
+            const uint16_t *pusColors;
+            uint16_t *pusOut = (uint16_t *)pucOut;
+            uint16_t usEntries = 0;
+            int16_t i;
+
+            // As for 8bpp, only translate as much of the palette as the row
+            // uses; grlib palettes hold just the image's numColors entries
+            for(i = lX0 & 1; i < (lX0 & 1) + lCount; i++)
+            {
+                Data = (pucData[i >> 1] >> ((i & 1) ? 0 : 4)) & 15;
+                if(Data >= usEntries)
+                {
+                    usEntries = Data + 1;
+                }
+            }
+            pusColors = Crystalfontz128x128_GetPalette(pucPalette, usEntries);
+#endif
+
             // Loop while there are more pixels to draw.  "Duff's device" is
             // used to jump into the middle of the loop if the first nibble of
             // the pixel data should not be used.  Duff's device makes use of
@@ -319,10 +1729,14 @@ static void Crystalfontz128x128_PixelDrawMultiple(const Graphics_Display *pDispl
                         // Get the upper nibble of the next byte of pixel data
                         // and extract the corresponding entry from the palette
                         Data = (*pucData >> 4);
+#if LCD_PALETTE_CACHED
+                        *pusOut++ = pusColors[Data];
+#else
                         Data = (*(uint16_t *)(pucPalette + Data));
-                        // Write to LCD screen
-                        HAL_LCD_writeData(Data>>8);
-                        HAL_LCD_writeData(Data);
+                        // Write to the line buffer
+                        *pucOut++ = Data >> 8;
+                        *pucOut++ = Data;
+#endif
 
                         // Decrement the count of pixels to draw
                         lCount--;
@@ -335,10 +1749,14 @@ static void Crystalfontz128x128_PixelDrawMultiple(const Graphics_Display *pDispl
                             // data and extract the corresponding entry from
                             // the palette
                             Data = (*pucData++ & 15);
+#if LCD_PALETTE_CACHED
+                            *pusOut++ = pusColors[Data];
+#else
                             Data = (*(uint16_t *)(pucPalette + Data));
-                            // Write to LCD screen
-                            HAL_LCD_writeData(Data>>8);
-                            HAL_LCD_writeData(Data);
+                            // Write to the line buffer
+                            *pucOut++ = Data >> 8;
+                            *pucOut++ = Data;
+#endif
 
                             // Decrement the count of pixels to draw
                             lCount--;
@@ -346,13 +1764,46 @@ static void Crystalfontz128x128_PixelDrawMultiple(const Graphics_Display *pDispl
                     }
             }
             // The image data has been drawn.
+#if LCD_PALETTE_CACHED
+            pucOut = (uint8_t *)pusOut;
+#endif
 
             break;
         }
+#endif
 
+#if LCD_IMAGE_FORMATS & LCD_IMAGE_8BPP
         // The pixel data is in 8 bit per pixel format
         case 8:
         {
+#if LCD_PALETTE_CACHED
+            const uint16_t *pusColors;
+            uint16_t *pusOut = (uint16_t *)pucOut;
+            uint16_t usEntries = 0;
+            int16_t i;
+
+            // Only translate as much of the palette as the image uses, so a
+            // short palette is never read past its end
+            for(i = 0; i < lCount; i++)
+            {
+                if(pucData[i] >= usEntries)
+                {
+                    usEntries = pucData[i] + 1;
+                }
+            }
+            pusColors = Crystalfontz128x128_GetPalette(pucPalette, usEntries);
+
+            // Loop while there are more pixels to draw
+            while(lCount--)
+            {
+                // Look the next byte of pixel data up in the translated
+                // palette
+                *pusOut++ = pusColors[*pucData++];
+            }
+            pucOut = (uint8_t *)pusOut;
+#else
+            uint16_t Data;
+
             // Loop while there are more pixels to draw
             while(lCount--)
             {
@@ -360,14 +1811,17 @@ static void Crystalfontz128x128_PixelDrawMultiple(const Graphics_Display *pDispl
                 // corresponding entry from the palette
                 Data = *pucData++;
                 Data = (*(uint16_t *)(pucPalette + Data));
-                // Write to LCD screen
-                HAL_LCD_writeData(Data>>8);
-                HAL_LCD_writeData(Data);
+                // Write to the line buffer
+                *pucOut++ = Data >> 8;
+                *pucOut++ = Data;
             }
+#endif
             // The image data has been drawn
             break;
         }
+#endif
 
+#if LCD_IMAGE_FORMATS & LCD_IMAGE_16BPP
         //
         // We are being passed data in the display's native format.  Merely
         // write it directly to the display.  This is a special case which is
@@ -387,12 +1841,40 @@ static void Crystalfontz128x128_PixelDrawMultiple(const Graphics_Display *pDispl
                 usData = *((uint16_t *)pucData);
                 pucData += 2;
 
-                // Translate this palette entry and write it to the screen
-                HAL_LCD_writeData(usData>>8);
-                HAL_LCD_writeData(usData);
+                // Byte-swap it into the line buffer
+                *pucOut++ = usData >> 8;
+                *pucOut++ = usData;
             }
+            break;
+        }
+#endif
+
+        default:
+        {
+            return;
         }
     }
+
+#if LCD_BUFFERED_DRAWING
+    if(Crystalfontz128x128_InBuffer(lY))
+    {
+        Crystalfontz128x128_BufferWrite(&Lcd_FrameBuffer, lX, lY, pucLine,
+                                        pucOut - pucLine);
+        Crystalfontz128x128_AddDirty(lX, lY, lX + lPixels - 1, lY);
+        return;
+    }
+    if (Lcd_Stripping)
+        return;
+#endif
+
+    Lcd_LineBufferIndex ^= 1;
+
+    //
+    // Set the cursor increment to left to right, followed by top to bottom.
+    //
+    Crystalfontz128x128_SetDrawFrame(lX,lY,lX+lPixels,127);
+    HAL_LCD_writeCommand(CM_RAMWR);
+    Crystalfontz128x128_WriteLine(pucLine, pucOut - pucLine);
 }
 
 
@@ -421,18 +1903,7 @@ static void Crystalfontz128x128_LineDrawH(const Graphics_Display *pDisplay,
 {
 
 
-    Crystalfontz128x128_SetDrawFrame(lX1, lY, lX2, lY);
-
-    //
-    // Write the pixel value.
-    //
-    int16_t i;
-    HAL_LCD_writeCommand(CM_RAMWR);
-    for (i = lX1; i <= lX2; i++)
-    {
-        HAL_LCD_writeData(ulValue>>8);
-        HAL_LCD_writeData(ulValue);
-    }
+    Crystalfontz128x128_Fill(lX1, lY, lX2, lY, ulValue);
 }
 
 
@@ -459,18 +1930,7 @@ static void Crystalfontz128x128_LineDrawV(const Graphics_Display *pDisplay,
                                           int16_t lY2,
                                           uint16_t ulValue)
 {
-    Crystalfontz128x128_SetDrawFrame(lX, lY1, lX, lY2);
-
-    //
-    // Write the pixel value.
-    //
-    int16_t i;
-    HAL_LCD_writeCommand(CM_RAMWR);
-    for (i = lY1; i <= lY2; i++)
-    {
-        HAL_LCD_writeData(ulValue>>8);
-        HAL_LCD_writeData(ulValue);
-    }
+    Crystalfontz128x128_Fill(lX, lY1, lX, lY2, ulValue);
 }
 
 
@@ -495,24 +1955,8 @@ static void Crystalfontz128x128_RectFill(const Graphics_Display *pDisplay,
                                          const Graphics_Rectangle *pRect,
                                          uint16_t ulValue)
 {
-    int16_t x0 = pRect->sXMin;
-    int16_t x1 = pRect->sXMax;
-    int16_t y0 = pRect->sYMin;
-    int16_t y1 = pRect->sYMax;
-
-    Crystalfontz128x128_SetDrawFrame(x0, y0, x1, y1);
-
-    //
-    // Write the pixel value.
-    //
-    int16_t i;
-    int16_t pixels = (x1 - x0 + 1) * (y1 - y0 + 1);
-    HAL_LCD_writeCommand(CM_RAMWR);
-    for (i = 0; i <= pixels; i++)
-    {
-        HAL_LCD_writeData(ulValue>>8);
-        HAL_LCD_writeData(ulValue);
-    }
+    Crystalfontz128x128_Fill(pRect->sXMin, pRect->sYMin,
+                             pRect->sXMax, pRect->sYMax, ulValue);
 }
 
 //*****************************************************************************
@@ -553,8 +1997,9 @@ static uint32_t Crystalfontz128x128_ColorTranslate(const Graphics_Display *pDisp
 //!
 //! This functions flushes any cached drawing operations to the display.  This
 //! is useful when a local frame buffer is used for drawing operations, and the
-//! flush would copy the local frame buffer to the display.  For the SSD2119
-//! driver, the flush is a no operation.
+//! flush would copy the local frame buffer to the display.  When buffering is
+//! on, only the regions of the framebuffer that changed since the last flush
+//! are sent.  The function returns once the last DMA transfer has completed.
 //!
 //! \return None.
 //
@@ -562,9 +2007,21 @@ static uint32_t Crystalfontz128x128_ColorTranslate(const Graphics_Display *pDisp
 static void
 Crystalfontz128x128_Flush(const Graphics_Display *pDisplay)
 {
+#if LCD_BUFFERED_DRAWING
     //
-    // There is nothing to be done.
+    // Crystalfontz128x128_RenderStrips() sends each strip itself.
     //
+    if (Lcd_Stripping)
+    {
+        return;
+    }
+    if (Lcd_Buffered)
+    {
+        Crystalfontz128x128_FlushDirty();
+    }
+#endif
+
+    HAL_LCD_waitDMA();
 }
 
 
@@ -604,6 +2061,102 @@ Graphics_Display g_sCrystalfontz128x128 =
     LCD_HORIZONTAL_MAX,
 };
 
+#if PROFILING
+//*****************************************************************************
+//
+// When profiling, grlib calls these instead of the functions above, so each
+// call through g_sCrystalfontz128x128_funcs is timed once however the
+// function returns, and calls between the functions themselves are not.
+//
+//*****************************************************************************
+static void Crystalfontz128x128_ProfiledPixelDraw(const Graphics_Display *pDisplay,
+                                                  int16_t lX, int16_t lY,
+                                                  uint16_t ulValue)
+{
+    PROFILE_BEGIN(PROFILE_LCD_PIXEL_DRAW);
+    Crystalfontz128x128_PixelDraw(pDisplay, lX, lY, ulValue);
+    PROFILE_END(PROFILE_LCD_PIXEL_DRAW);
+}
+
+static void Crystalfontz128x128_ProfiledPixelDrawMultiple(const Graphics_Display *pDisplay,
+                                                          int16_t lX, int16_t lY,
+                                                          int16_t lX0, int16_t lCount,
+                                                          int16_t lBPP,
+                                                          const uint8_t *pucData,
+                                                          const uint32_t *pucPalette)
+{
+    PROFILE_BEGIN(PROFILE_LCD_PIXEL_DRAW_MULTIPLE);
+    Crystalfontz128x128_PixelDrawMultiple(pDisplay, lX, lY, lX0, lCount, lBPP,
+                                          pucData, pucPalette);
+    PROFILE_END(PROFILE_LCD_PIXEL_DRAW_MULTIPLE);
+}
+
+static void Crystalfontz128x128_ProfiledLineDrawH(const Graphics_Display *pDisplay,
+                                                  int16_t lX1, int16_t lX2,
+                                                  int16_t lY, uint16_t ulValue)
+{
+    PROFILE_BEGIN(PROFILE_LCD_LINE_DRAW_H);
+    Crystalfontz128x128_LineDrawH(pDisplay, lX1, lX2, lY, ulValue);
+    PROFILE_END(PROFILE_LCD_LINE_DRAW_H);
+}
+
+static void Crystalfontz128x128_ProfiledLineDrawV(const Graphics_Display *pDisplay,
+                                                  int16_t lX, int16_t lY1,
+                                                  int16_t lY2, uint16_t ulValue)
+{
+    PROFILE_BEGIN(PROFILE_LCD_LINE_DRAW_V);
+    Crystalfontz128x128_LineDrawV(pDisplay, lX, lY1, lY2, ulValue);
+    PROFILE_END(PROFILE_LCD_LINE_DRAW_V);
+}
+
+static void Crystalfontz128x128_ProfiledRectFill(const Graphics_Display *pDisplay,
+                                                 const Graphics_Rectangle *pRect,
+                                                 uint16_t ulValue)
+{
+    PROFILE_BEGIN(PROFILE_LCD_RECT_FILL);
+    Crystalfontz128x128_RectFill(pDisplay, pRect, ulValue);
+    PROFILE_END(PROFILE_LCD_RECT_FILL);
+}
+
+static uint32_t Crystalfontz128x128_ProfiledColorTranslate(const Graphics_Display *pDisplay,
+                                                           uint32_t ulValue)
+{
+    uint32_t ulColor;
+
+    PROFILE_BEGIN(PROFILE_LCD_COLOR_TRANSLATE);
+    ulColor = Crystalfontz128x128_ColorTranslate(pDisplay, ulValue);
+    PROFILE_END(PROFILE_LCD_COLOR_TRANSLATE);
+
+    return ulColor;
+}
+
+static void Crystalfontz128x128_ProfiledFlush(const Graphics_Display *pDisplay)
+{
+    PROFILE_BEGIN(PROFILE_LCD_FLUSH);
+    Crystalfontz128x128_Flush(pDisplay);
+    PROFILE_END(PROFILE_LCD_FLUSH);
+}
+
+static void Crystalfontz128x128_ProfiledClearScreen(const Graphics_Display *pDisplay,
+                                                    uint16_t ulValue)
+{
+    PROFILE_BEGIN(PROFILE_LCD_CLEAR_SCREEN);
+    Crystalfontz128x128_ClearScreen(pDisplay, ulValue);
+    PROFILE_END(PROFILE_LCD_CLEAR_SCREEN);
+}
+
+const Graphics_Display_Functions g_sCrystalfontz128x128_funcs =
+{
+    Crystalfontz128x128_ProfiledPixelDraw,
+    Crystalfontz128x128_ProfiledPixelDrawMultiple,
+    Crystalfontz128x128_ProfiledLineDrawH,
+    Crystalfontz128x128_ProfiledLineDrawV,
+    Crystalfontz128x128_ProfiledRectFill,
+    Crystalfontz128x128_ProfiledColorTranslate,
+    Crystalfontz128x128_ProfiledFlush,
+    Crystalfontz128x128_ProfiledClearScreen
+};
+#else
 const Graphics_Display_Functions g_sCrystalfontz128x128_funcs =
 {
     Crystalfontz128x128_PixelDraw,
@@ -616,3 +2169,4 @@ const Graphics_Display_Functions g_sCrystalfontz128x128_funcs =
     Crystalfontz128x128_ClearScreen
 
 };
+#endif
@@ -48,10 +48,105 @@
 #define LCD_VERTICAL_MAX                   128
 #define LCD_HORIZONTAL_MAX                 128
 
+// Local framebuffer: number of full-width rows held in SRAM (2 bytes per
+// pixel), 0 to leave it out, LCD_VERTICAL_MAX for the whole screen
+#ifndef LCD_FRAMEBUFFER_ROWS
+#define LCD_FRAMEBUFFER_ROWS               0
+#endif
+
+// Number of separate dirty regions tracked before they get merged
+#ifndef LCD_FRAMEBUFFER_DIRTY_RECTS
+#define LCD_FRAMEBUFFER_DIRTY_RECTS        4
+#endif
+
+// Height of the strips of Crystalfontz128x128_RenderStrips(), in rows; two
+// strip buffers of 256 bytes per row are kept in SRAM.  0 to leave it out.
+#ifndef LCD_STRIP_ROWS
+#define LCD_STRIP_ROWS                     0
+#endif
+
+// Number of 4/8bpp image palettes kept translated to the panel's byte order
+// (512 bytes each), 0 to translate every pixel as it is drawn
+#ifndef LCD_PALETTE_CACHE_ENTRIES
+#define LCD_PALETTE_CACHE_ENTRIES          2
+#endif
+
+// Draw 1bpp rows (text, mostly) as runs of one color instead of decoding
+// them pixel by pixel; 0 for the per-pixel path
+#ifndef LCD_MONO_RUN_LENGTH
+#define LCD_MONO_RUN_LENGTH                1
+#endif
+
+// Bits per pixel on the SPI: 16 (RGB565), or 12 (RGB444) to send two pixels
+// in three bytes.  Colors are kept as RGB565 in SRAM either way.
+#ifndef LCD_COLOR_DEPTH
+#define LCD_COLOR_DEPTH                    16
+#endif
+
+// Waits of Crystalfontz128x128_InitAsync(), in microseconds: the reset pulse,
+// then from the reset to SLPOUT and from SLPOUT to the configuration, as
+// given in the ST7735 datasheet, and from the configuration to DISPON
+#define LCD_INIT_RESET_PULSE_US            50
+#define LCD_INIT_RESET_WAIT_US             120000
+#define LCD_INIT_SLEEP_OUT_WAIT_US         120000
+#define LCD_INIT_DISPLAY_ON_WAIT_US        10000
+
+#if (LCD_FRAMEBUFFER_ROWS < 0) || (LCD_FRAMEBUFFER_ROWS > LCD_VERTICAL_MAX)
+#error "LCD_FRAMEBUFFER_ROWS must be between 0 and LCD_VERTICAL_MAX"
+#endif
+
+#if (LCD_STRIP_ROWS < 0) || (LCD_STRIP_ROWS > LCD_VERTICAL_MAX)
+#error "LCD_STRIP_ROWS must be between 0 and LCD_VERTICAL_MAX"
+#endif
+
+#if (LCD_COLOR_DEPTH != 16) && (LCD_COLOR_DEPTH != 12)
+#error "LCD_COLOR_DEPTH must be 16 or 12"
+#endif
+
+// Whether the primitives can draw into SRAM at all
+#define LCD_BUFFERED_DRAWING  ((LCD_FRAMEBUFFER_ROWS > 0) || (LCD_STRIP_ROWS > 0))
+
 #define LCD_ORIENTATION_UP    0
 #define LCD_ORIENTATION_LEFT  1
 #define LCD_ORIENTATION_DOWN  2
 #define LCD_ORIENTATION_RIGHT 3
+// Orientation picked at run time, with Crystalfontz128x128_SetOrientation()
+#define LCD_ORIENTATION_RUNTIME 0xFF
+
+// Orientation fixed at build time, one of LCD_ORIENTATION_UP to _RIGHT, so
+// the address window offsets are constants; Crystalfontz128x128_SetOrientation()
+// then ignores its argument.  LCD_ORIENTATION_RUNTIME to keep all four.
+#ifndef LCD_FIXED_ORIENTATION
+#define LCD_FIXED_ORIENTATION              LCD_ORIENTATION_RUNTIME
+#endif
+
+// With a fixed orientation, LCD_PANEL_OFFSET_X and LCD_PANEL_OFFSET_Y may be
+// defined to where screen (0, 0) is in frame memory, for glass mounted other
+// than on the BoosterPack.  They default to the BoosterPack's offsets for
+// the orientation, which the hardware scrolling also assumes.
+#if (LCD_FIXED_ORIENTATION != LCD_ORIENTATION_RUNTIME) && \
+    ((LCD_FIXED_ORIENTATION < LCD_ORIENTATION_UP) || (LCD_FIXED_ORIENTATION > LCD_ORIENTATION_RIGHT))
+#error "LCD_FIXED_ORIENTATION must be an LCD_ORIENTATION_* value"
+#endif
+
+#if (LCD_FIXED_ORIENTATION == LCD_ORIENTATION_RUNTIME) && \
+    (defined(LCD_PANEL_OFFSET_X) || defined(LCD_PANEL_OFFSET_Y))
+#error "LCD_PANEL_OFFSET_X and LCD_PANEL_OFFSET_Y need LCD_FIXED_ORIENTATION"
+#endif
+
+// Image formats, for LCD_IMAGE_FORMATS
+#define LCD_IMAGE_1BPP        0x01
+#define LCD_IMAGE_4BPP        0x02
+#define LCD_IMAGE_8BPP        0x04
+#define LCD_IMAGE_16BPP       0x08
+
+// The formats the driver's PixelDrawMultiple decodes, as a mask of the
+// above; the decoders of the others are left out, and rows in them are not
+// drawn.  grlib draws opaque text as 1bpp rows, so it needs LCD_IMAGE_1BPP;
+// Crystalfontz128x128_DrawMonoBitmap() works either way.
+#ifndef LCD_IMAGE_FORMATS
+#define LCD_IMAGE_FORMATS  (LCD_IMAGE_1BPP | LCD_IMAGE_4BPP | LCD_IMAGE_8BPP | LCD_IMAGE_16BPP)
+#endif
 
 // ST7735 LCD controller Command Set
 #define CM_NOP             0x00
@@ -73,7 +168,9 @@
 #define CM_RGBSET          0x2d
 #define CM_RAMRD           0x2E
 #define CM_PTLAR           0x30
+#define CM_VSCRDEF         0x33
 #define CM_MADCTL          0x36
+#define CM_VSCSAD          0x37
 #define CM_COLMOD          0x3A
 #define CM_SETPWCTR        0xB1
 #define CM_SETDISPL        0xB2
@@ -92,10 +189,18 @@
 #define CM_MADCTL_BGR      0x08
 #define CM_MADCTL_MH       0x04
 
-extern uint8_t Lcd_Orientation;
-extern uint16_t Lcd_ScreenWidth, Lcd_ScreenHeigth;
-extern uint8_t Lcd_PenSolid, Lcd_FontSolid, Lcd_FlagRead;
-extern uint16_t Lcd_TouchTrim;
+//*****************************************************************************
+//
+// Panel-native images, for Crystalfontz128x128_DrawNativeImage(): RGB565
+// pixels, most significant byte first, rows top to bottom with no padding.
+// This is the byte stream the panel expects after RAMWR, so an image stored
+// as const data is sent straight from flash.  CRYSTALFONTZ_NATIVE_PIXEL()
+// expands an RGB565 value to its two bytes, for writing such arrays by hand:
+//
+//     const uint8_t image[] = { CRYSTALFONTZ_NATIVE_PIXEL(0xF800), ... };
+//
+//*****************************************************************************
+#define CRYSTALFONTZ_NATIVE_PIXEL(c)  (uint8_t)((c) >> 8), (uint8_t)(c)
 
 extern Graphics_Display g_sCrystalfontz128x128;
 
@@ -103,10 +208,42 @@ extern const Graphics_Display_Functions g_sCrystalfontz128x128_funcs;
 
 extern void Crystalfontz128x128_Init(void);
 
+extern void Crystalfontz128x128_InitAsync(void (*pfnDone)(void));
+
+extern bool Crystalfontz128x128_IsReady(void);
+
 extern void Crystalfontz128x128_SetDrawFrame(uint16_t x0, uint16_t y0, uint16_t x1, uint16_t y1);
 
+extern void Crystalfontz128x128_InvalidateDrawFrame(void);
+
 extern void Crystalfontz128x128_SetOrientation(uint8_t orientation);
 
+extern void Crystalfontz128x128_SetScrollArea(uint16_t top, uint16_t height, uint16_t bottom);
+
+extern void Crystalfontz128x128_ScrollTo(uint16_t line);
+
+extern void Crystalfontz128x128_SetBuffered(bool bBuffered);
+
+extern void Crystalfontz128x128_SetBufferOrigin(int16_t y);
+
+extern void Crystalfontz128x128_RenderStrips(Graphics_Context *psContext,
+                                             void (*pfnDraw)(Graphics_Context *psContext,
+                                                             void *pvArg),
+                                             void *pvArg);
+
+extern void Crystalfontz128x128_InvalidatePaletteCache(void);
+
+extern void Crystalfontz128x128_DrawNativeImage(int16_t x, int16_t y,
+                                                int16_t w, int16_t h,
+                                                const uint8_t *pucImage);
+
+extern void Crystalfontz128x128_DrawMonoBitmap(int16_t x, int16_t y,
+                                               int16_t w, int16_t h,
+                                               const uint8_t *pucBitmap,
+                                               uint16_t ulForeground,
+                                               uint16_t ulBackground,
+                                               bool bOpaque);
+
 
 
 #endif /* __CRYSTALFONTZLCD_H__ */
@@ -41,6 +41,64 @@
 #include <ti/grlib/grlib.h>
 #include <ti/devices/msp432p4xx/driverlib/driverlib.h>
 #include <stdint.h>
+#include "dma_table.h"
+#include "irq_priority.h"
+#include "profiler.h"
+#include "ramfunc.h"
+#include "sw_timer.h"
+
+// Largest number of items the uDMA moves in one basic-mode cycle
+#define LCD_DMA_MAX_TRANSFER  1024
+
+#if LCD_USE_DMA
+// Set while a transfer (possibly made of several DMA cycles) is in flight
+static volatile bool lcdDmaBusy = false;
+
+// Where the next DMA cycle reads from, and how many bytes are left after the
+// current cycle.  For a fill, the source is the pattern buffer and it does
+// not advance.
+static const uint8_t *lcdDmaSource;
+static uint32_t lcdDmaRemaining;
+static uint32_t lcdDmaSourceInc;
+static uint32_t lcdDmaBlockMax;
+// Set for fills, whose every cycle starts over at the pattern buffer
+static bool lcdDmaRewind;
+
+// Holds the repeated 2-byte color of a fill
+static uint8_t lcdDmaFillPattern[LCD_DMA_FILL_BUFFER_SIZE];
+
+// Called once the current transfer completes, then forgotten
+static void (*volatile lcdDmaCallback)(void);
+#endif
+
+// Timer and function of HAL_LCD_scheduleCallback()
+static SwTimer lcdTimer;
+static void (*lcdTimerCallback)(void);
+
+// SMCLK, and so the delay timer's clock, as of the last HAL_LCD_SpiInit()
+static uint32_t lcdSmclk;
+
+// Bytes sent to the panel, commands included, for HAL_LCD_getBytesSent()
+static uint32_t lcdBytesSent;
+
+// SPI clock set by HAL_LCD_SpiInit(), in Hz
+static uint32_t lcdSpiClock;
+
+#if LCD_TRANSFER_SELECT
+static HAL_LCD_TransferMode lcdTransferMode =
+        LCD_USE_DMA ? HAL_LCD_TRANSFER_DMA : HAL_LCD_TRANSFER_BURST;
+
+// In PIO mode a write waits for its byte to be out, as the driver once did
+#define LCD_WAIT_PIO()                                                       \
+    do {                                                                     \
+        if (lcdTransferMode == HAL_LCD_TRANSFER_PIO)                         \
+            while (UCB0STATW & UCBUSY);                                      \
+    } while (0)
+#define LCD_DMA_ALLOWED()     (lcdTransferMode == HAL_LCD_TRANSFER_DMA)
+#else
+#define LCD_WAIT_PIO()
+#define LCD_DMA_ALLOWED()     true
+#endif
 
 void HAL_LCD_PortInit(void)
 {
@@ -58,11 +116,18 @@ void HAL_LCD_PortInit(void)
 
 void HAL_LCD_SpiInit(void)
 {
+    //
+    // SPI_initMaster() rounds the clock divider down, which would run the
+    // bus faster than LCD_SPI_CLOCK_SPEED; ask for the rate that the rounded
+    // up divider gives instead.
+    //
+    uint32_t smclk = CS_getSMCLK();
+    uint32_t divider = (smclk + LCD_SPI_CLOCK_SPEED - 1) / LCD_SPI_CLOCK_SPEED;
     eUSCI_SPI_MasterConfig config =
         {
             EUSCI_B_SPI_CLOCKSOURCE_SMCLK,
-            LCD_SYSTEM_CLOCK_SPEED,
-            LCD_SPI_CLOCK_SPEED,
+            smclk,
+            smclk / divider,
             EUSCI_B_SPI_MSB_FIRST,
             EUSCI_B_SPI_PHASE_DATA_CAPTURED_ONFIRST_CHANGED_ON_NEXT,
             EUSCI_B_SPI_CLOCKPOLARITY_INACTIVITY_LOW,
@@ -71,12 +136,127 @@ void HAL_LCD_SpiInit(void)
     SPI_initMaster(LCD_EUSCI_BASE, &config);
     SPI_enableModule(LCD_EUSCI_BASE);
 
+    lcdSmclk = smclk;
+    lcdSpiClock = smclk / divider;
+
     GPIO_setOutputLowOnPin(LCD_CS_PORT, LCD_CS_PIN);
 
     GPIO_setOutputHighOnPin(LCD_DC_PORT, LCD_DC_PIN);
 }
 
 
+//*****************************************************************************
+//
+// Recomputes the SPI clock divider after SMCLK has changed, once the transfer
+// in progress has finished.  Made to be called through a clock change
+// notification.
+//
+//*****************************************************************************
+void HAL_LCD_updateSpiClock(void)
+{
+    HAL_LCD_waitDMA();
+    while (UCB0STATW & UCBUSY);
+
+    HAL_LCD_SpiInit();
+}
+
+
+//*****************************************************************************
+//
+// Only turns the compare interrupt off again: HAL_LCD_delayMicroseconds()
+// polls the flag, and needs the interrupt only to wake from LPM0.
+//
+//*****************************************************************************
+void TA2_0_IRQHandler(void)
+{
+    LCD_DELAY_TIMER->CCTL[0] &= ~TIMER_A_CCTLN_CCIE;
+}
+
+
+//*****************************************************************************
+//
+// Waits for at least the given number of microseconds.
+//
+// The CPU sleeps in LPM0 while LCD_DELAY_TIMER, clocked by SMCLK, counts the
+// time.  Waits shorter than LCD_DELAY_SPIN_US, and waits from an ISR, where
+// the timer interrupt could not wake the CPU, spin at the current
+// SystemCoreClock instead; every pass of that loop takes no less than 4
+// cycles.  Either way the delay can only come out longer than asked, which
+// is what the panel's reset and power-up timings need.
+//
+//*****************************************************************************
+void HAL_LCD_delayMicroseconds(uint32_t us)
+{
+    uint64_t ticks;
+
+    if (us < LCD_DELAY_SPIN_US || lcdSmclk == 0 || __get_IPSR() != 0)
+    {
+        uint32_t loops = us * (SystemCoreClock / 1000000) / 4;
+
+        while (loops--)
+        {
+            __delay_cycles(4);
+        }
+        return;
+    }
+
+    // One more tick covers the partial one the timer is in when it starts
+    ticks = ((uint64_t)us * lcdSmclk + 999999) / 1000000 + 1;
+
+    LCD_DELAY_TIMER->CTL = TIMER_A_CTL_TASSEL_2 | TIMER_A_CTL_MC__CONTINUOUS |
+                           TIMER_A_CTL_CLR;
+    IrqPriority_enableInterrupt(LCD_DELAY_INT_NUM, IRQ_LEVEL_LCD_DELAY);
+
+    while (ticks)
+    {
+        // Long waits go in half-range steps, so the last step is never so
+        // short that the counter could pass the compare value before it is set
+        uint16_t chunk = (ticks > 0xFFFF) ? 0x8000 : (uint16_t)ticks;
+        ticks -= chunk;
+
+        LCD_DELAY_TIMER->CCR[0] = LCD_DELAY_TIMER->R + chunk;
+        LCD_DELAY_TIMER->CCTL[0] = TIMER_A_CCTLN_CCIE;
+
+        while (!(LCD_DELAY_TIMER->CCTL[0] & TIMER_A_CCTLN_CCIFG))
+        {
+            // As in HAL_LCD_waitDMA(), the compare interrupt still wakes the
+            // CPU if it comes in between the check and the sleep
+            bool wasDisabled = Interrupt_disableMaster();
+            if (!(LCD_DELAY_TIMER->CCTL[0] & TIMER_A_CCTLN_CCIFG))
+                PCM_gotoLPM0();
+            if (!wasDisabled)
+                Interrupt_enableMaster();
+        }
+
+        // With interrupts disabled the ISR has not run; do not leave the
+        // interrupt pending
+        LCD_DELAY_TIMER->CCTL[0] = 0;
+        Interrupt_unpendInterrupt(LCD_DELAY_INT_NUM);
+    }
+
+    LCD_DELAY_TIMER->CTL = TIMER_A_CTL_MC__STOP;
+}
+
+
+static void HAL_LCD_timerExpired(void *arg)
+{
+    lcdTimerCallback();
+}
+
+//*****************************************************************************
+//
+// Calls a function once the given number of microseconds have passed, from
+// the software timer ISR, without waiting for them.  Replaces any callback
+// already scheduled.  The software timers must have been initialized.
+//
+//*****************************************************************************
+void HAL_LCD_scheduleCallback(uint32_t us, void (*callback)(void))
+{
+    lcdTimerCallback = callback;
+    SwTimer_start(&lcdTimer, us, 0, HAL_LCD_timerExpired, 0);
+}
+
+
 //*****************************************************************************
 //
 // Writes a command to the CFAF128128B-0145T.  This function implements the basic SPI
@@ -85,20 +265,32 @@ void HAL_LCD_SpiInit(void)
 //*****************************************************************************
 void HAL_LCD_writeCommand(uint8_t command)
 {
-    // Set to command mode
-    GPIO_setOutputLowOnPin(LCD_DC_PORT, LCD_DC_PIN);
+    PROFILE_BEGIN(PROFILE_LCD_WRITE_COMMAND);
 
-    // USCI_B0 Busy? //
+#if LCD_USE_DMA
+    // Let any pending pixel transfer finish before touching DC
+    if (lcdDmaBusy)
+        HAL_LCD_waitDMA();
+#endif
+
+    // Data written by the pipelined writes may still be shifting out; DC
+    // must not change until it is gone
     while (UCB0STATW & UCBUSY);
 
+    // Set to command mode
+    GPIO_setOutputLowOnPin(LCD_DC_PORT, LCD_DC_PIN);
+
     // Transmit data
     UCB0TXBUF = command;
+    lcdBytesSent++;
 
     // USCI_B0 Busy? //
     while (UCB0STATW & UCBUSY);
 
     // Set back to data mode
     GPIO_setOutputHighOnPin(LCD_DC_PORT, LCD_DC_PIN);
+
+    PROFILE_END(PROFILE_LCD_WRITE_COMMAND);
 }
 
 
@@ -107,17 +299,476 @@ void HAL_LCD_writeCommand(uint8_t command)
 // Writes a data to the CFAF128128B-0145T.  This function implements the basic SPI
 // interface to the LCD display.
 //
+// The byte is queued in the TX buffer as soon as it is free, so it shifts out
+// while the caller prepares the next one.  HAL_LCD_writeCommand() waits for
+// the bus to go idle before changing DC.
+//
 //*****************************************************************************
-void HAL_LCD_writeData(uint8_t data)
+RAMFUNC void HAL_LCD_writeData(uint8_t data)
 {
-    // USCI_B0 Busy? //
-    while (UCB0STATW & UCBUSY);
+#if LCD_USE_DMA
+    if (lcdDmaBusy)
+        HAL_LCD_waitDMA();
+#endif
+
+    // USCI_B0 TX buffer free? //
+    while (!(UCB0IFG & UCTXIFG));
 
     // Transmit data
     UCB0TXBUF = data;
+    lcdBytesSent++;
+    LCD_WAIT_PIO();
+}
+
+
+//*****************************************************************************
+//
+//! Writes a block of data to the CFAF128128B-0145T.
+//!
+//! \param data points to the bytes to send.
+//! \param len is the number of bytes to send.
+//!
+//! Each byte is loaded into the TX buffer while the previous one shifts out,
+//! so the bus runs back to back at LCD_SPI_CLOCK_SPEED.
+//!
+//! \return None.
+//
+//*****************************************************************************
+RAMFUNC void HAL_LCD_writeBurst(const uint8_t *data, uint32_t len)
+{
+#if LCD_USE_DMA
+    if (lcdDmaBusy)
+        HAL_LCD_waitDMA();
+#endif
+
+    lcdBytesSent += len;
+    while (len--)
+    {
+        while (!(UCB0IFG & UCTXIFG));
+        UCB0TXBUF = *data++;
+        LCD_WAIT_PIO();
+    }
+}
+
+
+//*****************************************************************************
+//
+//! Writes the same 16-bit color to the CFAF128128B-0145T a number of times.
+//!
+//! \param color is the pixel value, sent most significant byte first.
+//! \param count is the number of pixels to send.
+//!
+//! \return None.
+//
+//*****************************************************************************
+RAMFUNC void HAL_LCD_writeRepeat16(uint16_t color, uint32_t count)
+{
+    uint8_t hi = color >> 8;
+    uint8_t lo = color;
+
+#if LCD_USE_DMA
+    if (lcdDmaBusy)
+        HAL_LCD_waitDMA();
+#endif
+
+    lcdBytesSent += count * 2;
+    while (count--)
+    {
+        while (!(UCB0IFG & UCTXIFG));
+        UCB0TXBUF = hi;
+        LCD_WAIT_PIO();
+        while (!(UCB0IFG & UCTXIFG));
+        UCB0TXBUF = lo;
+        LCD_WAIT_PIO();
+    }
+}
+
+
+//*****************************************************************************
+//
+//! Writes the same group of bytes to the CFAF128128B-0145T a number of times.
+//!
+//! \param pattern points to the bytes to repeat.
+//! \param len is the number of bytes in the pattern.
+//! \param count is the number of times the pattern is sent.
+//!
+//! This sends runs of pixels that do not fit in 16 bits, such as the pairs of
+//! 12-bit pixels packed into three bytes.
+//!
+//! \return None.
+//
+//*****************************************************************************
+RAMFUNC void HAL_LCD_writeRepeat(const uint8_t *pattern, uint32_t len, uint32_t count)
+{
+    uint32_t i;
+
+#if LCD_USE_DMA
+    if (lcdDmaBusy)
+        HAL_LCD_waitDMA();
+#endif
+
+    lcdBytesSent += count * len;
+    while (count--)
+    {
+        for (i = 0; i < len; i++)
+        {
+            while (!(UCB0IFG & UCTXIFG));
+            UCB0TXBUF = pattern[i];
+            LCD_WAIT_PIO();
+        }
+    }
+}
+
+#if LCD_USE_DMA
+//*****************************************************************************
+//
+// Programs the next DMA cycle of the current transfer and starts it.
+//
+//*****************************************************************************
+static void HAL_LCD_startDMABlock(void)
+{
+    uint32_t len = lcdDmaRemaining;
+
+    if (len > lcdDmaBlockMax)
+        len = lcdDmaBlockMax;
+
+    DMA_setChannelControl(UDMA_PRI_SELECT | LCD_DMA_CHANNEL,
+                          UDMA_SIZE_8 | lcdDmaSourceInc | UDMA_DST_INC_NONE | UDMA_ARB_1);
+    DMA_setChannelTransfer(UDMA_PRI_SELECT | LCD_DMA_CHANNEL,
+                           UDMA_MODE_BASIC,
+                           (void *)lcdDmaSource,
+                           (void *)SPI_getTransmitBufferAddressForDMA(LCD_EUSCI_BASE),
+                           len);
+
+    lcdDmaRemaining -= len;
+    if ((lcdDmaSourceInc == UDMA_SRC_INC_8) && !lcdDmaRewind)
+        lcdDmaSource += len;
+
+    DMA_enableChannel(LCD_DMA_CHANNEL_NUM);
+
+    // A byte queued by a pipelined write may still sit in the TX buffer
+    while (!(UCB0IFG & UCTXIFG));
+
+    // The DMA request is raised by a transition of UCTXIFG, which is already
+    // set while the SPI is idle.  Re-raise it to move the first byte.
+    UCB0IFG &= ~UCTXIFG;
+    UCB0IFG |= UCTXIFG;
+}
+
+//*****************************************************************************
+//
+// DMA completion interrupt.  Chains the next cycle of a transfer longer than
+// one DMA cycle, or marks the transfer done.
+//
+//*****************************************************************************
+void DMA_INT1_IRQHandler(void)
+{
+    DMA_clearInterruptFlag(LCD_DMA_CHANNEL_NUM);
+
+    if (lcdDmaRemaining)
+    {
+        HAL_LCD_startDMABlock();
+    }
+    else
+    {
+        void (*callback)(void) = lcdDmaCallback;
+
+        lcdDmaBusy = false;
+        if (callback)
+        {
+            lcdDmaCallback = 0;
+            callback();
+        }
+    }
+}
+#endif
+
+
+//*****************************************************************************
+//
+// Sets up the uDMA channel that feeds EUSCI_B0.  Must be called after
+// HAL_LCD_SpiInit().
+//
+//*****************************************************************************
+void HAL_LCD_DmaInit(void)
+{
+#if LCD_USE_DMA
+    DmaTable_init();
+
+    DMA_assignChannel(LCD_DMA_CHANNEL);
+    DMA_disableChannelAttribute(LCD_DMA_CHANNEL,
+                                UDMA_ATTR_ALTSELECT | UDMA_ATTR_USEBURST |
+                                UDMA_ATTR_HIGH_PRIORITY | UDMA_ATTR_REQMASK);
+
+    DMA_assignInterrupt(LCD_DMA_INT, LCD_DMA_CHANNEL_NUM);
+    DMA_clearInterruptFlag(LCD_DMA_CHANNEL_NUM);
+    IrqPriority_enableInterrupt(LCD_DMA_INT_NUM, IRQ_LEVEL_LCD_DMA);
+#endif
+}
+
+
+//*****************************************************************************
+//
+//! Starts sending a block of data to the CFAF128128B-0145T.
+//!
+//! \param data points to the bytes to send.  The buffer must stay untouched
+//! until the transfer completes (see HAL_LCD_waitDMA()).
+//! \param len is the number of bytes to send.
+//!
+//! The function returns as soon as the transfer is started, so the CPU can
+//! prepare the next block or sleep while EUSCI_B0 transmits.  The next call
+//! to any HAL_LCD_write function waits for it to complete first.
+//!
+//! \return None.
+//
+//*****************************************************************************
+void HAL_LCD_writeDataDMA(const uint8_t *data, uint32_t len)
+{
+#if LCD_USE_DMA
+    if (len == 0)
+        return;
+
+    if (!LCD_DMA_ALLOWED())
+    {
+        HAL_LCD_writeBurst(data, len);
+        return;
+    }
+
+    HAL_LCD_waitDMA();
+
+    lcdDmaSource = data;
+    lcdDmaSourceInc = UDMA_SRC_INC_8;
+    lcdDmaBlockMax = LCD_DMA_MAX_TRANSFER;
+    lcdDmaRewind = false;
+    lcdDmaRemaining = len;
+    lcdBytesSent += len;
+    lcdDmaBusy = true;
+
+    HAL_LCD_startDMABlock();
+#else
+    HAL_LCD_writeBurst(data, len);
+#endif
+}
+
+
+//*****************************************************************************
+//
+//! Starts sending the same 16-bit color a number of times.
+//!
+//! \param color is the pixel value, sent most significant byte first.
+//! \param count is the number of pixels to send.
+//!
+//! Like HAL_LCD_writeDataDMA(), this function returns once the transfer is
+//! started.
+//!
+//! \return None.
+//
+//*****************************************************************************
+void HAL_LCD_fillDMA(uint16_t color, uint32_t count)
+{
+    uint8_t pattern[2];
+
+    pattern[0] = color >> 8;
+    pattern[1] = color;
+    HAL_LCD_fillPatternDMA(pattern, 2, count);
+}
+
+
+//*****************************************************************************
+//
+//! Starts sending the same group of bytes a number of times.
+//!
+//! \param pattern points to the bytes to repeat.  They are copied, so the
+//! caller may reuse them at once.
+//! \param len is the number of bytes in the pattern, at most
+//! LCD_DMA_FILL_BUFFER_SIZE.
+//! \param count is the number of times the pattern is sent.
+//!
+//! Like HAL_LCD_writeDataDMA(), this function returns once the transfer is
+//! started.
+//!
+//! \return None.
+//
+//*****************************************************************************
+void HAL_LCD_fillPatternDMA(const uint8_t *pattern, uint32_t len, uint32_t count)
+{
+#if LCD_USE_DMA
+    uint32_t i;
+
+    if ((count == 0) || (len == 0))
+        return;
+
+    if (!LCD_DMA_ALLOWED())
+    {
+        HAL_LCD_writeRepeat(pattern, len, count);
+        return;
+    }
+
+    HAL_LCD_waitDMA();
+
+    for (i = 1; i < len; i++)
+    {
+        if (pattern[i] != pattern[0])
+            break;
+    }
+
+    if (i == len)
+    {
+        // All the bytes are equal (black, white, ...): send a single byte
+        // over and over without moving the source
+        lcdDmaFillPattern[0] = pattern[0];
+        lcdDmaSourceInc = UDMA_SRC_INC_NONE;
+        lcdDmaBlockMax = LCD_DMA_MAX_TRANSFER;
+    }
+    else
+    {
+        // Otherwise fill the buffer with whole copies of the pattern and
+        // resend it, restarting it every cycle
+        lcdDmaBlockMax = LCD_DMA_FILL_BUFFER_SIZE - LCD_DMA_FILL_BUFFER_SIZE % len;
+        for (i = 0; i < lcdDmaBlockMax; i++)
+            lcdDmaFillPattern[i] = pattern[i % len];
+        lcdDmaSourceInc = UDMA_SRC_INC_8;
+    }
+
+    lcdDmaSource = lcdDmaFillPattern;
+    lcdDmaRewind = true;
+    lcdDmaRemaining = count * len;
+    lcdBytesSent += count * len;
+    lcdDmaBusy = true;
+
+    HAL_LCD_startDMABlock();
+#else
+    HAL_LCD_writeRepeat(pattern, len, count);
+#endif
+}
+
+
+//*****************************************************************************
+//
+// Returns the number of bytes sent to the LCD so far, commands included.  It
+// wraps around; the difference between two readings is what was sent
+// between them.  A DMA transfer counts in full as soon as it is started.
+//
+//*****************************************************************************
+uint32_t HAL_LCD_getBytesSent(void)
+{
+    return lcdBytesSent;
+}
+
+
+//*****************************************************************************
+//
+// Returns the SPI clock, in Hz, set for the current SMCLK.
+//
+//*****************************************************************************
+uint32_t HAL_LCD_getSpiClock(void)
+{
+    return lcdSpiClock;
+}
+
+
+//*****************************************************************************
+//
+//! Selects how bytes are moved to the SPI from now on.
+//!
+//! \param mode is one of the HAL_LCD_TRANSFER_ values.
+//!
+//! Without LCD_TRANSFER_SELECT, only the mode the driver was built for is
+//! accepted: HAL_LCD_TRANSFER_DMA, or HAL_LCD_TRANSFER_BURST when LCD_USE_DMA
+//! is 0.  HAL_LCD_TRANSFER_DMA always needs LCD_USE_DMA.
+//!
+//! \return true if the mode is in use, false if it is not available.
+//
+//*****************************************************************************
+bool HAL_LCD_setTransferMode(HAL_LCD_TransferMode mode)
+{
+#if LCD_TRANSFER_SELECT
+    if ((mode == HAL_LCD_TRANSFER_DMA) && !LCD_USE_DMA)
+        return false;
+
+    HAL_LCD_waitDMA();
+    lcdTransferMode = mode;
+    return true;
+#else
+    return mode == (LCD_USE_DMA ? HAL_LCD_TRANSFER_DMA : HAL_LCD_TRANSFER_BURST);
+#endif
+}
+
+
+//*****************************************************************************
+//
+// Returns true while a DMA transfer to the LCD is in progress.
+//
+//*****************************************************************************
+bool HAL_LCD_isDMABusy(void)
+{
+#if LCD_USE_DMA
+    return lcdDmaBusy;
+#else
+    return false;
+#endif
+}
+
+
+//*****************************************************************************
+//
+//! Calls a function once the current DMA transfer has finished.
+//!
+//! \param callback is called from the DMA completion interrupt, or right
+//! away if no transfer is in progress.  Only the last byte may still be
+//! shifting out; the next HAL_LCD_write function waits for it.
+//!
+//! \return None.
+//
+//*****************************************************************************
+void HAL_LCD_whenDMADone(void (*callback)(void))
+{
+#if LCD_USE_DMA
+    uint8_t previousMask = IrqPriority_enter(IRQ_LEVEL_LCD_DMA);
+
+    if (lcdDmaBusy)
+    {
+        lcdDmaCallback = callback;
+        callback = 0;
+    }
+
+    IrqPriority_exit(previousMask);
+
+    if (callback)
+        callback();
+#else
+    callback();
+#endif
+}
+
+
+//*****************************************************************************
+//
+//! Waits for the current DMA transfer to finish.
+//!
+//! The CPU sleeps in LPM0 until the completion interrupt, then waits for the
+//! last byte to leave the shift register so DC and CS can safely change.
+//! Must not be called with interrupts disabled.
+//!
+//! \return None.
+//
+//*****************************************************************************
+void HAL_LCD_waitDMA(void)
+{
+#if LCD_USE_DMA
+    while (lcdDmaBusy)
+    {
+        // Masking interrupts between the check and the sleep makes sure the
+        // completion interrupt cannot slip in between; it still wakes the CPU
+        Interrupt_disableMaster();
+        if (lcdDmaBusy)
+            PCM_gotoLPM0();
+        Interrupt_enableMaster();
+    }
 
     // USCI_B0 Busy? //
     while (UCB0STATW & UCBUSY);
+#endif
 }
 
 //*****************************************************************************
@@ -49,9 +49,8 @@
 //
 //*****************************************************************************
 
-// System clock speed (in Hz)
-#define LCD_SYSTEM_CLOCK_SPEED                 48000000
-// SPI clock speed (in Hz)
+// Maximum SPI clock speed (in Hz).  The actual speed is SMCLK divided by the
+// smallest integer that does not exceed this; see HAL_LCD_SpiInit().
 #define LCD_SPI_CLOCK_SPEED                    16000000
 
 // Ports from MSP432 connected to LCD
@@ -73,6 +72,61 @@
 // Definition of USCI base address to be used for SPI communication
 #define LCD_EUSCI_BASE        EUSCI_B0_BASE
 
+// Set to 0 to send every pixel with the CPU instead of the uDMA
+#ifndef LCD_USE_DMA
+#define LCD_USE_DMA           1
+#endif
+
+// Set to 1 to allow HAL_LCD_setTransferMode() to switch between sending a
+// byte at a time, CPU bursts and the uDMA at run time, for benchmarking.  It
+// adds a test to every write.
+#ifndef LCD_TRANSFER_SELECT
+#define LCD_TRANSFER_SELECT   0
+#endif
+
+// uDMA channel (EUSCI_B0 TX trigger) and completion interrupt used for the LCD
+#define LCD_DMA_CHANNEL       DMA_CH0_EUSCIB0TX0
+#define LCD_DMA_CHANNEL_NUM   0
+#define LCD_DMA_INT           DMA_INT1
+#define LCD_DMA_INT_NUM       INT_DMA_INT1
+
+// TimerA behind HAL_LCD_delay(), and its CCR0 interrupt.  Its ISR,
+// TA2_0_IRQHandler, is defined by this driver.
+#define LCD_DELAY_TIMER       TIMER_A2
+#define LCD_DELAY_INT_NUM     INT_TA2_0
+
+// HAL_LCD_delay() spins instead of sleeping for waits shorter than this, in
+// microseconds, where waking up would take longer than the wait
+#ifndef LCD_DELAY_SPIN_US
+#define LCD_DELAY_SPIN_US     10
+#endif
+
+// Spans shorter than this (in pixels) are sent by the CPU, since setting up
+// a DMA transfer costs more than it saves on a handful of bytes
+#ifndef LCD_DMA_THRESHOLD
+#define LCD_DMA_THRESHOLD     32
+#endif
+
+// Size (in bytes) of the pattern buffer used to DMA a two-color fill
+#ifndef LCD_DMA_FILL_BUFFER_SIZE
+#define LCD_DMA_FILL_BUFFER_SIZE 256
+#endif
+
+//*****************************************************************************
+//
+// Ways of moving bytes to the SPI, for HAL_LCD_setTransferMode()
+//
+//*****************************************************************************
+typedef enum
+{
+    // Every byte waits for the bus to go idle before the next one
+    HAL_LCD_TRANSFER_PIO,
+    // Bytes are queued while the previous one shifts out
+    HAL_LCD_TRANSFER_BURST,
+    // Long spans go through the uDMA
+    HAL_LCD_TRANSFER_DMA
+} HAL_LCD_TransferMode;
+
 //*****************************************************************************
 //
 // Prototypes for the globals exported by this driver.
@@ -80,8 +134,24 @@
 //*****************************************************************************
 extern void HAL_LCD_writeCommand(uint8_t command);
 extern void HAL_LCD_writeData(uint8_t data);
+extern void HAL_LCD_writeBurst(const uint8_t *data, uint32_t len);
+extern void HAL_LCD_writeRepeat16(uint16_t color, uint32_t count);
+extern void HAL_LCD_writeRepeat(const uint8_t *pattern, uint32_t len, uint32_t count);
 extern void HAL_LCD_PortInit(void);
 extern void HAL_LCD_SpiInit(void);
+extern void HAL_LCD_updateSpiClock(void);
+extern void HAL_LCD_delayMicroseconds(uint32_t us);
+extern void HAL_LCD_scheduleCallback(uint32_t us, void (*callback)(void));
+extern void HAL_LCD_DmaInit(void);
+extern void HAL_LCD_writeDataDMA(const uint8_t *data, uint32_t len);
+extern void HAL_LCD_fillDMA(uint16_t color, uint32_t count);
+extern void HAL_LCD_fillPatternDMA(const uint8_t *pattern, uint32_t len, uint32_t count);
+extern bool HAL_LCD_isDMABusy(void);
+extern uint32_t HAL_LCD_getBytesSent(void);
+extern uint32_t HAL_LCD_getSpiClock(void);
+extern bool HAL_LCD_setTransferMode(HAL_LCD_TransferMode mode);
+extern void HAL_LCD_whenDMADone(void (*callback)(void));
+extern void HAL_LCD_waitDMA(void);
 
 // Custom __delay_cycles() for non CCS Compiler
 #if !defined( __TI_ARM__ )
@@ -90,6 +160,7 @@ extern void HAL_LCD_SpiInit(void);
 void SysCtlDelay(uint32_t);
 #endif
 
-#define HAL_LCD_delay(x)      __delay_cycles(x * 48)
+// Waits x microseconds, not milliseconds or cycles
+#define HAL_LCD_delay(x)      HAL_LCD_delayMicroseconds(x)
 
 #endif /* HAL_MSP_EXP432P401R_CRYSTALFONTZ128X128_ST7735_H_ */
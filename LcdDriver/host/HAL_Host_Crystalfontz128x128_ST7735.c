@@ -0,0 +1,214 @@
+//*****************************************************************************
+//
+// HAL_Host_Crystalfontz128x128_ST7735.c - The LCD HAL on a PC, sending every
+//                                         byte to ST7735_Emulator.
+//
+// It takes the place of HAL_MSP_EXP432P401R_Crystalfontz128x128_ST7735.c, with
+// the same interface.  Transfers are done by the time a function returns, so
+// the DMA is never busy, and delays only move the emulator's time on.
+//
+//*****************************************************************************
+
+#include "HAL_MSP_EXP432P401R_Crystalfontz128x128_ST7735.h"
+#include "ST7735_Emulator.h"
+#include "sleep_manager.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+// The SPI clock the board would run at, for HAL_LCD_getSpiClock()
+#define HOST_SPI_CLOCK        12000000
+
+// Level of the panel's reset line
+static bool hostResetHigh = true;
+
+static uint32_t hostBytesSent;
+
+// Callback of HAL_LCD_scheduleCallback() and its delay, until
+// ST7735_runTimers() runs it
+static void (*hostTimerCallback)(void);
+static uint32_t hostTimerDelay;
+
+
+//*****************************************************************************
+//
+// The GPIO calls of the driver.  Only the reset line does anything: its
+// falling edge resets the panel.
+//
+//*****************************************************************************
+void GPIO_setOutputHighOnPin(uint_fast8_t selectedPort, uint_fast16_t selectedPins)
+{
+    if ((selectedPort == LCD_RST_PORT) && (selectedPins & LCD_RST_PIN))
+    {
+        hostResetHigh = true;
+    }
+}
+
+void GPIO_setOutputLowOnPin(uint_fast8_t selectedPort, uint_fast16_t selectedPins)
+{
+    if ((selectedPort == LCD_RST_PORT) && (selectedPins & LCD_RST_PIN))
+    {
+        if (hostResetHigh)
+        {
+            ST7735_reset();
+        }
+        hostResetHigh = false;
+    }
+}
+
+
+//*****************************************************************************
+//
+// There are no low power modes on the host.
+//
+//*****************************************************************************
+void SleepManager_blockLPM3(uint32_t reasons)
+{
+}
+
+void SleepManager_unblockLPM3(uint32_t reasons)
+{
+}
+
+
+void HAL_LCD_PortInit(void)
+{
+}
+
+void HAL_LCD_SpiInit(void)
+{
+}
+
+void HAL_LCD_updateSpiClock(void)
+{
+}
+
+void HAL_LCD_DmaInit(void)
+{
+}
+
+
+void HAL_LCD_writeCommand(uint8_t command)
+{
+    hostBytesSent++;
+    ST7735_command(command);
+}
+
+void HAL_LCD_writeData(uint8_t data)
+{
+    hostBytesSent++;
+    ST7735_data(data);
+}
+
+void HAL_LCD_writeBurst(const uint8_t *data, uint32_t len)
+{
+    while (len--)
+    {
+        HAL_LCD_writeData(*data++);
+    }
+}
+
+void HAL_LCD_writeRepeat16(uint16_t color, uint32_t count)
+{
+    while (count--)
+    {
+        HAL_LCD_writeData(color >> 8);
+        HAL_LCD_writeData(color);
+    }
+}
+
+void HAL_LCD_writeRepeat(const uint8_t *pattern, uint32_t len, uint32_t count)
+{
+    while (count--)
+    {
+        HAL_LCD_writeBurst(pattern, len);
+    }
+}
+
+void HAL_LCD_writeDataDMA(const uint8_t *data, uint32_t len)
+{
+    if (len == 0)
+        return;
+
+    ST7735_countDmaTransfer();
+    HAL_LCD_writeBurst(data, len);
+}
+
+void HAL_LCD_fillDMA(uint16_t color, uint32_t count)
+{
+    uint8_t pattern[2];
+
+    pattern[0] = color >> 8;
+    pattern[1] = color;
+    HAL_LCD_fillPatternDMA(pattern, 2, count);
+}
+
+void HAL_LCD_fillPatternDMA(const uint8_t *pattern, uint32_t len, uint32_t count)
+{
+    if ((len == 0) || (count == 0))
+        return;
+
+    ST7735_countDmaTransfer();
+    HAL_LCD_writeRepeat(pattern, len, count);
+}
+
+bool HAL_LCD_isDMABusy(void)
+{
+    return false;
+}
+
+void HAL_LCD_whenDMADone(void (*callback)(void))
+{
+    callback();
+}
+
+void HAL_LCD_waitDMA(void)
+{
+}
+
+uint32_t HAL_LCD_getBytesSent(void)
+{
+    return hostBytesSent;
+}
+
+uint32_t HAL_LCD_getSpiClock(void)
+{
+    return HOST_SPI_CLOCK;
+}
+
+bool HAL_LCD_setTransferMode(HAL_LCD_TransferMode mode)
+{
+    //
+    // Every mode sends the same bytes, which is all the emulator sees; only
+    // the modes the board would accept are.
+    //
+#if LCD_TRANSFER_SELECT
+    return (mode != HAL_LCD_TRANSFER_DMA) || LCD_USE_DMA;
+#else
+    return mode == (LCD_USE_DMA ? HAL_LCD_TRANSFER_DMA : HAL_LCD_TRANSFER_BURST);
+#endif
+}
+
+
+void HAL_LCD_delayMicroseconds(uint32_t us)
+{
+    ST7735_addTime(us);
+}
+
+void HAL_LCD_scheduleCallback(uint32_t us, void (*callback)(void))
+{
+    hostTimerCallback = callback;
+    hostTimerDelay = us;
+}
+
+void ST7735_runTimers(void)
+{
+    void (*callback)(void);
+
+    while (hostTimerCallback)
+    {
+        callback = hostTimerCallback;
+        hostTimerCallback = 0;
+        ST7735_addTime(hostTimerDelay);
+        callback();
+    }
+}
@@ -0,0 +1,564 @@
+//*****************************************************************************
+//
+// ST7735_Emulator.c - A model of the ST7735 behind the Crystalfontz 128x128
+//                     panel, for running the display driver on a PC.
+//
+//*****************************************************************************
+
+#include "ST7735_Emulator.h"
+#include "Crystalfontz128x128_ST7735.h"
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+// No command is taking data
+#define ST7735_NO_COMMAND       0x100
+
+// Most parameter bytes of the commands that are decoded
+#define ST7735_MAX_PARAMETERS   6
+
+// Frame memory, row-major, as RGB565
+static uint16_t Emu_Memory[ST7735_MEMORY_ROWS][ST7735_MEMORY_COLUMNS];
+
+static uint8_t Emu_Madctl;
+static uint8_t Emu_Colmod;
+static bool Emu_Sleeping;
+static bool Emu_DisplayOn;
+
+// Address window of CASET and RASET
+static uint16_t Emu_X0, Emu_X1, Emu_Y0, Emu_Y1;
+
+// Scrolling area of VSCRDEF and start of VSCSAD, decoded but not applied
+static uint16_t Emu_ScrollTop, Emu_ScrollHeight, Emu_ScrollBottom;
+static uint16_t Emu_ScrollStart;
+
+// The command taking data, and its parameters so far
+static uint16_t Emu_Command = ST7735_NO_COMMAND;
+static uint8_t Emu_Parameters[ST7735_MAX_PARAMETERS];
+static uint8_t Emu_ParameterCount;
+
+// Write pointer of RAMWR, in window addresses, and whether it has wrapped
+// around the window
+static uint16_t Emu_Column, Emu_Row;
+static bool Emu_Wrapped;
+
+// Bytes of the pixel, or 12-bit pair, being received
+static uint8_t Emu_PixelBytes[3];
+static uint8_t Emu_PixelByteCount;
+
+// Level of DC for the last byte: true for data
+static bool Emu_Data = true;
+
+static ST7735_Counters Emu_Counters;
+static ST7735_Counters Emu_PrimitiveCounters[ST7735_PRIMITIVE_COUNT];
+static uint32_t Emu_PrimitiveCalls[ST7735_PRIMITIVE_COUNT];
+
+static uint64_t Emu_Time;
+
+
+//*****************************************************************************
+//
+// Widens the components of a 12-bit pixel to RGB565.
+//
+//*****************************************************************************
+static uint16_t ST7735_From444(uint16_t usPixel)
+{
+    uint16_t r = (usPixel >> 8) & 0xF;
+    uint16_t g = (usPixel >> 4) & 0xF;
+    uint16_t b = usPixel & 0xF;
+
+    return (((r << 1) | (r >> 3)) << 11) | (((g << 2) | (g >> 2)) << 5) |
+           ((b << 1) | (b >> 3));
+}
+
+
+//*****************************************************************************
+//
+// Stores a pixel at the write pointer, through MADCTL, and moves the pointer
+// on along the window.
+//
+//*****************************************************************************
+static void ST7735_writePixel(uint16_t usPixel)
+{
+    uint16_t usRow, usColumn;
+
+    Emu_Counters.ulPixels++;
+    if (Emu_Wrapped)
+    {
+        Emu_Counters.ulOverruns++;
+    }
+
+    //
+    // MV swaps the addresses over, then MY and MX mirror the memory rows and
+    // columns.
+    //
+    if (Emu_Madctl & CM_MADCTL_MV)
+    {
+        usRow = Emu_Column;
+        usColumn = Emu_Row;
+    }
+    else
+    {
+        usRow = Emu_Row;
+        usColumn = Emu_Column;
+    }
+
+    if ((usRow >= ST7735_MEMORY_ROWS) || (usColumn >= ST7735_MEMORY_COLUMNS))
+    {
+        Emu_Counters.ulHidden++;
+    }
+    else
+    {
+        if (Emu_Madctl & CM_MADCTL_MY)
+            usRow = ST7735_MEMORY_ROWS - 1 - usRow;
+        if (Emu_Madctl & CM_MADCTL_MX)
+            usColumn = ST7735_MEMORY_COLUMNS - 1 - usColumn;
+
+        Emu_Memory[usRow][usColumn] = usPixel;
+
+        if ((usRow < ST7735_VISIBLE_ROW) ||
+            (usRow >= ST7735_VISIBLE_ROW + ST7735_VISIBLE_SIZE) ||
+            (usColumn < ST7735_VISIBLE_COLUMN) ||
+            (usColumn >= ST7735_VISIBLE_COLUMN + ST7735_VISIBLE_SIZE))
+        {
+            Emu_Counters.ulHidden++;
+        }
+    }
+
+    if (++Emu_Column > Emu_X1)
+    {
+        Emu_Column = Emu_X0;
+        if (++Emu_Row > Emu_Y1)
+        {
+            Emu_Row = Emu_Y0;
+            Emu_Wrapped = true;
+        }
+    }
+}
+
+
+//*****************************************************************************
+//
+// Takes a byte of RAMWR data, in the pixel format set by COLMOD.
+//
+//*****************************************************************************
+static void ST7735_pixelData(uint8_t ucData)
+{
+    Emu_PixelBytes[Emu_PixelByteCount++] = ucData;
+
+    switch (Emu_Colmod & 0x07)
+    {
+    case 0x03:
+        //
+        // Two pixels in three bytes; the first is complete after the second
+        // byte.
+        //
+        if (Emu_PixelByteCount == 2)
+        {
+            ST7735_writePixel(ST7735_From444((Emu_PixelBytes[0] << 4) |
+                                             (Emu_PixelBytes[1] >> 4)));
+        }
+        else if (Emu_PixelByteCount == 3)
+        {
+            ST7735_writePixel(ST7735_From444(((Emu_PixelBytes[1] & 0xF) << 8) |
+                                             Emu_PixelBytes[2]));
+            Emu_PixelByteCount = 0;
+        }
+        break;
+
+    case 0x05:
+        if (Emu_PixelByteCount == 2)
+        {
+            ST7735_writePixel((Emu_PixelBytes[0] << 8) | Emu_PixelBytes[1]);
+            Emu_PixelByteCount = 0;
+        }
+        break;
+
+    default:
+        //
+        // 18 bits, one byte per component with the top 6 bits used.
+        //
+        if (Emu_PixelByteCount == 3)
+        {
+            ST7735_writePixel(((Emu_PixelBytes[0] >> 3) << 11) |
+                              ((Emu_PixelBytes[1] >> 2) << 5) |
+                              (Emu_PixelBytes[2] >> 3));
+            Emu_PixelByteCount = 0;
+        }
+        break;
+    }
+}
+
+
+//*****************************************************************************
+//
+// Applies a command once all of its parameters are in.
+//
+//*****************************************************************************
+static void ST7735_parameters(void)
+{
+    const uint8_t *p = Emu_Parameters;
+
+    switch (Emu_Command)
+    {
+    case CM_CASET:
+        if (Emu_ParameterCount == 4)
+        {
+            Emu_X0 = (p[0] << 8) | p[1];
+            Emu_X1 = (p[2] << 8) | p[3];
+            Emu_Command = ST7735_NO_COMMAND;
+        }
+        break;
+
+    case CM_RASET:
+        if (Emu_ParameterCount == 4)
+        {
+            Emu_Y0 = (p[0] << 8) | p[1];
+            Emu_Y1 = (p[2] << 8) | p[3];
+            Emu_Command = ST7735_NO_COMMAND;
+        }
+        break;
+
+    case CM_MADCTL:
+        Emu_Madctl = p[0];
+        Emu_Command = ST7735_NO_COMMAND;
+        break;
+
+    case CM_COLMOD:
+        Emu_Colmod = p[0];
+        Emu_Command = ST7735_NO_COMMAND;
+        break;
+
+    case CM_VSCRDEF:
+        if (Emu_ParameterCount == 6)
+        {
+            Emu_ScrollTop = (p[0] << 8) | p[1];
+            Emu_ScrollHeight = (p[2] << 8) | p[3];
+            Emu_ScrollBottom = (p[4] << 8) | p[5];
+            Emu_Command = ST7735_NO_COMMAND;
+        }
+        break;
+
+    case CM_VSCSAD:
+        if (Emu_ParameterCount == 2)
+        {
+            Emu_ScrollStart = (p[0] << 8) | p[1];
+            Emu_Command = ST7735_NO_COMMAND;
+        }
+        break;
+
+    default:
+        //
+        // The parameters of the other commands (power, gamma, frame rate)
+        // change nothing that is modelled.
+        //
+        if (Emu_ParameterCount == ST7735_MAX_PARAMETERS)
+        {
+            Emu_ParameterCount = 0;
+        }
+        break;
+    }
+}
+
+
+//*****************************************************************************
+//
+// Puts the panel state back to its power-on values, without the counters.
+//
+//*****************************************************************************
+static void ST7735_resetState(void)
+{
+    memset(Emu_Memory, 0, sizeof(Emu_Memory));
+    Emu_Madctl = 0;
+    Emu_Colmod = 0x06;
+    Emu_Sleeping = true;
+    Emu_DisplayOn = false;
+    Emu_X0 = 0;
+    Emu_X1 = ST7735_MEMORY_COLUMNS - 1;
+    Emu_Y0 = 0;
+    Emu_Y1 = ST7735_MEMORY_ROWS - 1;
+    Emu_ScrollTop = 0;
+    Emu_ScrollHeight = ST7735_MEMORY_ROWS;
+    Emu_ScrollBottom = 0;
+    Emu_ScrollStart = 0;
+    Emu_Command = ST7735_NO_COMMAND;
+    Emu_ParameterCount = 0;
+    Emu_PixelByteCount = 0;
+}
+
+
+void ST7735_reset(void)
+{
+    ST7735_resetState();
+    ST7735_resetCounters();
+}
+
+
+void ST7735_command(uint8_t ucCommand)
+{
+    Emu_Counters.ulBytes++;
+    Emu_Counters.ulCommands++;
+    if (Emu_Data)
+    {
+        Emu_Counters.ulDcToggles++;
+        Emu_Data = false;
+    }
+
+    //
+    // A command ends RAMWR, and drops the bytes of a pixel not complete.
+    //
+    Emu_Command = ucCommand;
+    Emu_ParameterCount = 0;
+    Emu_PixelByteCount = 0;
+
+    switch (ucCommand)
+    {
+    case CM_SWRESET:
+        ST7735_resetState();
+        break;
+
+    case CM_SLPIN:
+        Emu_Sleeping = true;
+        break;
+
+    case CM_SLPOUT:
+        Emu_Sleeping = false;
+        break;
+
+    case CM_DISPOFF:
+        Emu_DisplayOn = false;
+        break;
+
+    case CM_DISPON:
+        Emu_DisplayOn = true;
+        break;
+
+    case CM_RAMWR:
+        Emu_Column = Emu_X0;
+        Emu_Row = Emu_Y0;
+        Emu_Wrapped = false;
+        break;
+
+    default:
+        break;
+    }
+}
+
+
+void ST7735_data(uint8_t ucData)
+{
+    Emu_Counters.ulBytes++;
+    if (!Emu_Data)
+    {
+        Emu_Counters.ulDcToggles++;
+        Emu_Data = true;
+    }
+
+    if (Emu_Command == CM_RAMWR)
+    {
+        ST7735_pixelData(ucData);
+        return;
+    }
+
+    if (Emu_Command == ST7735_NO_COMMAND)
+    {
+        Emu_Counters.ulStrayData++;
+        return;
+    }
+
+    Emu_Parameters[Emu_ParameterCount++] = ucData;
+    ST7735_parameters();
+}
+
+
+void ST7735_countDmaTransfer(void)
+{
+    Emu_Counters.ulDmaTransfers++;
+}
+
+
+uint16_t ST7735_getMemoryPixel(uint16_t usColumn, uint16_t usRow)
+{
+    if ((usRow >= ST7735_MEMORY_ROWS) || (usColumn >= ST7735_MEMORY_COLUMNS))
+        return 0;
+
+    return Emu_Memory[usRow][usColumn];
+}
+
+
+uint16_t ST7735_getScreenPixel(int16_t x, int16_t y)
+{
+    int16_t sAlongRows = (Emu_Madctl & CM_MADCTL_MV) ? x : y;
+    int16_t sAlongColumns = (Emu_Madctl & CM_MADCTL_MV) ? y : x;
+    uint16_t usRow, usColumn;
+
+    if ((x < 0) || (x >= ST7735_VISIBLE_SIZE) ||
+        (y < 0) || (y >= ST7735_VISIBLE_SIZE))
+    {
+        return 0;
+    }
+
+    if (Emu_Madctl & CM_MADCTL_MY)
+        usRow = ST7735_VISIBLE_ROW + ST7735_VISIBLE_SIZE - 1 - sAlongRows;
+    else
+        usRow = ST7735_VISIBLE_ROW + sAlongRows;
+
+    if (Emu_Madctl & CM_MADCTL_MX)
+        usColumn = ST7735_VISIBLE_COLUMN + ST7735_VISIBLE_SIZE - 1 - sAlongColumns;
+    else
+        usColumn = ST7735_VISIBLE_COLUMN + sAlongColumns;
+
+    return Emu_Memory[usRow][usColumn];
+}
+
+
+void ST7735_getCounters(ST7735_Counters *psCounters)
+{
+    *psCounters = Emu_Counters;
+}
+
+
+void ST7735_getPrimitiveCounters(ST7735_Primitive ePrimitive,
+                                 ST7735_Counters *psCounters,
+                                 uint32_t *pulCalls)
+{
+    *psCounters = Emu_PrimitiveCounters[ePrimitive];
+    *pulCalls = Emu_PrimitiveCalls[ePrimitive];
+}
+
+
+void ST7735_resetCounters(void)
+{
+    memset(&Emu_Counters, 0, sizeof(Emu_Counters));
+    memset(Emu_PrimitiveCounters, 0, sizeof(Emu_PrimitiveCounters));
+    memset(Emu_PrimitiveCalls, 0, sizeof(Emu_PrimitiveCalls));
+}
+
+
+bool ST7735_isDisplayOn(void)
+{
+    return !Emu_Sleeping && Emu_DisplayOn;
+}
+
+
+uint64_t ST7735_getTime(void)
+{
+    return Emu_Time;
+}
+
+
+void ST7735_addTime(uint32_t ulMicroseconds)
+{
+    Emu_Time += ulMicroseconds;
+}
+
+
+//*****************************************************************************
+//
+// Counting wrappers.  Each adds the difference in the counters across one
+// call to its primitive.
+//
+//*****************************************************************************
+static void ST7735_countSince(ST7735_Primitive ePrimitive,
+                              const ST7735_Counters *psBefore)
+{
+    ST7735_Counters *psTotal = &Emu_PrimitiveCounters[ePrimitive];
+
+    Emu_PrimitiveCalls[ePrimitive]++;
+    psTotal->ulBytes += Emu_Counters.ulBytes - psBefore->ulBytes;
+    psTotal->ulCommands += Emu_Counters.ulCommands - psBefore->ulCommands;
+    psTotal->ulDcToggles += Emu_Counters.ulDcToggles - psBefore->ulDcToggles;
+    psTotal->ulPixels += Emu_Counters.ulPixels - psBefore->ulPixels;
+    psTotal->ulOverruns += Emu_Counters.ulOverruns - psBefore->ulOverruns;
+    psTotal->ulHidden += Emu_Counters.ulHidden - psBefore->ulHidden;
+    psTotal->ulStrayData += Emu_Counters.ulStrayData - psBefore->ulStrayData;
+    psTotal->ulDmaTransfers += Emu_Counters.ulDmaTransfers - psBefore->ulDmaTransfers;
+}
+
+static void ST7735_countPixelDraw(const Graphics_Display *pDisplay,
+                                  int16_t lX, int16_t lY, uint16_t ulValue)
+{
+    ST7735_Counters sBefore = Emu_Counters;
+
+    g_sCrystalfontz128x128_funcs.pfnPixelDraw(pDisplay, lX, lY, ulValue);
+    ST7735_countSince(ST7735_PIXEL_DRAW, &sBefore);
+}
+
+static void ST7735_countPixelDrawMultiple(const Graphics_Display *pDisplay,
+                                          int16_t lX, int16_t lY,
+                                          int16_t lX0, int16_t lCount,
+                                          int16_t lBPP,
+                                          const uint8_t *pucData,
+                                          const uint32_t *pucPalette)
+{
+    ST7735_Counters sBefore = Emu_Counters;
+
+    g_sCrystalfontz128x128_funcs.pfnPixelDrawMultiple(pDisplay, lX, lY, lX0, lCount,
+                                                      lBPP, pucData, pucPalette);
+    ST7735_countSince(ST7735_PIXEL_DRAW_MULTIPLE, &sBefore);
+}
+
+static void ST7735_countLineDrawH(const Graphics_Display *pDisplay,
+                                  int16_t lX1, int16_t lX2,
+                                  int16_t lY, uint16_t ulValue)
+{
+    ST7735_Counters sBefore = Emu_Counters;
+
+    g_sCrystalfontz128x128_funcs.pfnLineDrawH(pDisplay, lX1, lX2, lY, ulValue);
+    ST7735_countSince(ST7735_LINE_DRAW_H, &sBefore);
+}
+
+static void ST7735_countLineDrawV(const Graphics_Display *pDisplay,
+                                  int16_t lX, int16_t lY1,
+                                  int16_t lY2, uint16_t ulValue)
+{
+    ST7735_Counters sBefore = Emu_Counters;
+
+    g_sCrystalfontz128x128_funcs.pfnLineDrawV(pDisplay, lX, lY1, lY2, ulValue);
+    ST7735_countSince(ST7735_LINE_DRAW_V, &sBefore);
+}
+
+static void ST7735_countRectFill(const Graphics_Display *pDisplay,
+                                 const Graphics_Rectangle *pRect,
+                                 uint16_t ulValue)
+{
+    ST7735_Counters sBefore = Emu_Counters;
+
+    g_sCrystalfontz128x128_funcs.pfnRectFill(pDisplay, pRect, ulValue);
+    ST7735_countSince(ST7735_RECT_FILL, &sBefore);
+}
+
+static uint32_t ST7735_countColorTranslate(const Graphics_Display *pDisplay,
+                                           uint32_t ulValue)
+{
+    return g_sCrystalfontz128x128_funcs.pfnColorTranslate(pDisplay, ulValue);
+}
+
+static void ST7735_countFlush(const Graphics_Display *pDisplay)
+{
+    ST7735_Counters sBefore = Emu_Counters;
+
+    g_sCrystalfontz128x128_funcs.pfnFlush(pDisplay);
+    ST7735_countSince(ST7735_FLUSH, &sBefore);
+}
+
+static void ST7735_countClearScreen(const Graphics_Display *pDisplay,
+                                    uint16_t ulValue)
+{
+    ST7735_Counters sBefore = Emu_Counters;
+
+    g_sCrystalfontz128x128_funcs.pfnClearDisplay(pDisplay, ulValue);
+    ST7735_countSince(ST7735_CLEAR_SCREEN, &sBefore);
+}
+
+const Graphics_Display_Functions g_sST7735_countingFuncs =
+{
+    ST7735_countPixelDraw,
+    ST7735_countPixelDrawMultiple,
+    ST7735_countLineDrawH,
+    ST7735_countLineDrawV,
+    ST7735_countRectFill,
+    ST7735_countColorTranslate,
+    ST7735_countFlush,
+    ST7735_countClearScreen
+};
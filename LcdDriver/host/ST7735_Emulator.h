@@ -0,0 +1,124 @@
+//*****************************************************************************
+//
+// ST7735_Emulator.h - A model of the ST7735 behind the Crystalfontz 128x128
+//                     panel, for running the display driver on a PC.
+//
+// HAL_Host_Crystalfontz128x128_ST7735.c implements the LCD HAL on top of it:
+// every command and data byte the driver sends is decoded as the panel
+// would (CASET, RASET, RAMWR, MADCTL, COLMOD, VSCRDEF, VSCSAD), into a copy
+// of its frame memory, and counted.  Drawing can then be checked pixel for
+// pixel, and the SPI traffic of every primitive measured exactly.
+//
+// To build on a PC, put LcdDriver/host/include first on the include path,
+// where it stands in for driverlib, and add the SDK's grlib sources:
+//
+//     gcc -ILcdDriver/host/include -I<SDK>/source -I. -ILcdDriver
+//         LcdDriver/Crystalfontz128x128_*.c LcdDriver/host/*.c
+//         <SDK>/source/ti/grlib/*.c <your program>.c
+//
+// LcdDriver/host/checks holds such programs, each checking one part of the
+// driver; LcdDriver/host/Makefile builds and runs them all.  The firmware
+// project leaves LcdDriver/host out of its build.
+//
+// LCD_USE_DMA has no effect: every transfer is done by the time the HAL
+// returns.
+//
+//*****************************************************************************
+
+#ifndef __ST7735_EMULATOR_H__
+#define __ST7735_EMULATOR_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <ti/grlib/grlib.h>
+
+// Frame memory of the ST7735 as the Crystalfontz panel sets it up, and the
+// part of it that is visible
+#define ST7735_MEMORY_COLUMNS   132
+#define ST7735_MEMORY_ROWS      132
+#define ST7735_VISIBLE_COLUMN   2
+#define ST7735_VISIBLE_ROW      1
+#define ST7735_VISIBLE_SIZE     128
+
+typedef struct
+{
+    // Bytes on the SPI, commands included
+    uint32_t ulBytes;
+    // Command bytes
+    uint32_t ulCommands;
+    // Changes of the DC line between command and data
+    uint32_t ulDcToggles;
+    // Pixels written to the frame memory
+    uint32_t ulPixels;
+    // Pixels written past the end of the address window, which the panel
+    // wraps back to its start
+    uint32_t ulOverruns;
+    // Pixels written to frame memory that is not visible
+    uint32_t ulHidden;
+    // Pixel bytes sent without a RAMWR before them
+    uint32_t ulStrayData;
+    // Transfers started with HAL_LCD_writeDataDMA() or a DMA fill
+    uint32_t ulDmaTransfers;
+} ST7735_Counters;
+
+// The entries of g_sCrystalfontz128x128_funcs, for ST7735_getPrimitiveCounters()
+typedef enum
+{
+    ST7735_PIXEL_DRAW,
+    ST7735_PIXEL_DRAW_MULTIPLE,
+    ST7735_LINE_DRAW_H,
+    ST7735_LINE_DRAW_V,
+    ST7735_RECT_FILL,
+    ST7735_FLUSH,
+    ST7735_CLEAR_SCREEN,
+    ST7735_PRIMITIVE_COUNT
+} ST7735_Primitive;
+
+// Wraps g_sCrystalfontz128x128_funcs, adding up what every call sends into
+// its primitive's counters
+extern const Graphics_Display_Functions g_sST7735_countingFuncs;
+
+// Puts the panel in its state after a hardware reset, and clears the
+// counters.  Called when the driver pulls the reset line low.
+extern void ST7735_reset(void);
+
+// Decode one byte sent with DC low (command) or high (data)
+extern void ST7735_command(uint8_t ucCommand);
+extern void ST7735_data(uint8_t ucData);
+
+// Counts a DMA transfer; its bytes come through ST7735_data()
+extern void ST7735_countDmaTransfer(void);
+
+// Returns a pixel of the frame memory, as RGB565.  12-bit pixels are
+// widened to RGB565 by repeating their top bits.
+extern uint16_t ST7735_getMemoryPixel(uint16_t usColumn, uint16_t usRow);
+
+// Returns the pixel shown at screen coordinates (x, y) for the current
+// MADCTL, as the driver's orientations map them; scrolling is not applied
+extern uint16_t ST7735_getScreenPixel(int16_t x, int16_t y);
+
+// Returns the counters since ST7735_reset() or ST7735_resetCounters()
+extern void ST7735_getCounters(ST7735_Counters *psCounters);
+
+// Returns what the calls through g_sST7735_countingFuncs sent, for one
+// primitive, and how many calls there were
+extern void ST7735_getPrimitiveCounters(ST7735_Primitive ePrimitive,
+                                        ST7735_Counters *psCounters,
+                                        uint32_t *pulCalls);
+
+extern void ST7735_resetCounters(void);
+
+// Whether the panel is awake and showing its memory (SLPOUT and DISPON)
+extern bool ST7735_isDisplayOn(void);
+
+// Time spent in HAL_LCD_delay() and pending callbacks, in microseconds
+extern uint64_t ST7735_getTime(void);
+
+// Runs the callbacks of HAL_LCD_scheduleCallback(), as the timer interrupt
+// would, until none is left, moving the time on by their delays
+extern void ST7735_runTimers(void);
+
+// Internal to the host HAL
+extern void ST7735_addTime(uint32_t ulMicroseconds);
+
+#endif /* __ST7735_EMULATOR_H__ */
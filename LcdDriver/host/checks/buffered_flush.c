@@ -0,0 +1,97 @@
+//*****************************************************************************
+//
+// buffered_flush.c - Checks that the framebuffer reaches the panel pixel for
+//                    pixel, for dirty regions of every width.
+//
+// Regions narrower than the screen are sent as one RAMWR; at 12 bits per
+// pixel, rows of an odd width end in the middle of a pair.  Build and run it
+// with LcdDriver/host/Makefile, which gives it a framebuffer.  It prints the
+// first wrong pixel of each region and returns non-zero if there is one.
+//
+//*****************************************************************************
+
+#include <stdio.h>
+#include "Crystalfontz128x128_ST7735.h"
+#include "host/ST7735_Emulator.h"
+
+#if LCD_FRAMEBUFFER_ROWS != LCD_VERTICAL_MAX
+#error "build with LCD_FRAMEBUFFER_ROWS=128"
+#endif
+
+#define WHITE   0xFFFF
+#define RED     0xF800
+
+// The emulator widens 12-bit pixels back to RGB565 by repeating their top
+// bits, so compare them on the bits they keep
+#if LCD_COLOR_DEPTH == 12
+#define SAME_COLOR(a, b)  ((((a) ^ (b)) & 0xF79E) == 0)
+#else
+#define SAME_COLOR(a, b)  ((a) == (b))
+#endif
+
+static const Graphics_Display *display = &g_sCrystalfontz128x128;
+
+// Fills a region through the framebuffer, flushes it, and compares the
+// whole screen with it on a white background
+static int check(int16_t x0, int16_t y0, int16_t x1, int16_t y1)
+{
+    const Graphics_Display_Functions *funcs = &g_sCrystalfontz128x128_funcs;
+    Graphics_Rectangle rect = { x0, y0, x1, y1 };
+    int16_t x, y;
+    uint16_t expected, shown;
+    int bad = 0;
+
+    funcs->pfnClearDisplay(display, WHITE);
+    funcs->pfnFlush(display);
+
+    if (x0 == x1)
+    {
+        funcs->pfnLineDrawV(display, x0, y0, y1, RED);
+    }
+    else
+    {
+        funcs->pfnRectFill(display, &rect, RED);
+    }
+    funcs->pfnFlush(display);
+
+    for (y = 0; y < LCD_VERTICAL_MAX; y++)
+    {
+        for (x = 0; x < LCD_HORIZONTAL_MAX; x++)
+        {
+            expected = (x >= x0 && x <= x1 && y >= y0 && y <= y1) ? RED : WHITE;
+            shown = ST7735_getScreenPixel(x, y);
+            if (!SAME_COLOR(shown, expected))
+            {
+                if (!bad)
+                {
+                    printf("%d,%d-%d,%d: first wrong pixel at %d,%d: %04x, not %04x\n",
+                           x0, y0, x1, y1, x, y, shown, expected);
+                }
+                bad++;
+            }
+        }
+    }
+
+    return bad;
+}
+
+int main(void)
+{
+    int bad = 0;
+
+    Crystalfontz128x128_Init();
+    Crystalfontz128x128_SetOrientation(LCD_ORIENTATION_UP);
+    Crystalfontz128x128_SetBuffered(true);
+
+    // Odd widths, a pixel wide to one short of the screen, then even ones
+    bad += check(10, 20, 10, 30);
+    bad += check(5, 40, 7, 47);
+    bad += check(0, 60, 126, 62);
+    bad += check(20, 70, 21, 80);
+    bad += check(1, 90, 100, 95);
+    // Full width, sent as one contiguous run
+    bad += check(0, 100, 127, 104);
+
+    printf("%s\n", bad ? "FAIL" : "ok");
+    return bad != 0;
+}
@@ -0,0 +1,96 @@
+//*****************************************************************************
+//
+// display_list.c - Checks that image rows recorded by the display list reach
+//                  the panel, whatever formats LCD_IMAGE_FORMATS keeps.
+//
+// The list expands 4 and 8bpp rows to RGB565 and sends them back later, so
+// they must not depend on the driver decoding 16bpp rows.  The Makefile
+// builds it without LCD_IMAGE_16BPP.  It prints the first wrong pixel of
+// each row and returns non-zero if there is one.
+//
+//*****************************************************************************
+
+#include <stdio.h>
+#include "Crystalfontz128x128_ST7735.h"
+#include "Crystalfontz128x128_DisplayList.h"
+#include "host/ST7735_Emulator.h"
+
+#define WHITE   0xFFFF
+
+// The emulator widens 12-bit pixels back to RGB565 by repeating their top
+// bits, so compare them on the bits they keep
+#if LCD_COLOR_DEPTH == 12
+#define SAME_COLOR(a, b)  ((((a) ^ (b)) & 0xF79E) == 0)
+#else
+#define SAME_COLOR(a, b)  ((a) == (b))
+#endif
+
+static const Graphics_Display *display = &g_sCrystalfontz128x128;
+
+// Palette entries as PixelDrawMultiple takes them: already translated
+static const uint32_t palette[16] =
+{
+    0xF800, 0x07E0, 0x001F, 0xFFE0, 0xF81F, 0x07FF, 0x0000, 0x8410,
+    0x4208, 0xC618, 0x1234, 0x4321, 0xA5A5, 0x5A5A, 0x0F0F, 0xF0F0
+};
+
+static uint16_t expected(int16_t lBPP, const uint8_t *pucData, int16_t i)
+{
+    if (lBPP == 4)
+    {
+        return (uint16_t)palette[(pucData[i >> 1] >> ((i & 1) ? 0 : 4)) & 15];
+    }
+    return (uint16_t)palette[pucData[i]];
+}
+
+static int check(int16_t lBPP, int16_t lY)
+{
+    const Graphics_Display_Functions *funcs = &g_sCrystalfontz128x128_listFuncs;
+    uint8_t data[64];
+    int16_t x;
+    uint16_t shown;
+    int bad = 0;
+
+    for (x = 0; x < 64; x++)
+    {
+        data[x] = (lBPP == 4) ? (uint8_t)(x * 37) : (uint8_t)(x & 15);
+    }
+
+    g_sCrystalfontz128x128_funcs.pfnClearDisplay(display, WHITE);
+    funcs->pfnPixelDrawMultiple(display, 0, lY, 0, 64, lBPP, data, palette);
+    funcs->pfnFlush(display);
+
+    for (x = 0; x < 64; x++)
+    {
+        shown = ST7735_getScreenPixel(x, lY);
+        if (!SAME_COLOR(shown, expected(lBPP, data, x)))
+        {
+            if (!bad)
+            {
+                printf("%dbpp row %d: first wrong pixel at %d: %04x, not %04x\n",
+                       lBPP, lY, x, shown, expected(lBPP, data, x));
+            }
+            bad++;
+        }
+    }
+
+    return bad;
+}
+
+int main(void)
+{
+    int bad = 0;
+
+    Crystalfontz128x128_Init();
+    Crystalfontz128x128_SetOrientation(LCD_ORIENTATION_UP);
+
+#if LCD_IMAGE_FORMATS & LCD_IMAGE_4BPP
+    bad += check(4, 40);
+#endif
+#if LCD_IMAGE_FORMATS & LCD_IMAGE_8BPP
+    bad += check(8, 80);
+#endif
+
+    printf("%s\n", bad ? "FAIL" : "ok");
+    return bad != 0;
+}
@@ -0,0 +1,95 @@
+//*****************************************************************************
+//
+// rect_fill.c - Checks that RectFill writes exactly the pixels of its
+//               rectangle: none past the address window, which the panel
+//               would wrap back to its first row, and none hidden.
+//
+// Build and run it with LcdDriver/host/Makefile.  It prints the first wrong
+// pixel of each rectangle and returns non-zero if there is one.
+//
+//*****************************************************************************
+
+#include <stdio.h>
+#include "Crystalfontz128x128_ST7735.h"
+#include "host/ST7735_Emulator.h"
+
+#define WHITE   0xFFFF
+#define BLUE    0x001F
+
+// The emulator widens 12-bit pixels back to RGB565 by repeating their top
+// bits, so compare them on the bits they keep
+#if LCD_COLOR_DEPTH == 12
+#define SAME_COLOR(a, b)  ((((a) ^ (b)) & 0xF79E) == 0)
+#else
+#define SAME_COLOR(a, b)  ((a) == (b))
+#endif
+
+static const Graphics_Display *display = &g_sCrystalfontz128x128;
+
+static int check(int16_t x0, int16_t y0, int16_t x1, int16_t y1)
+{
+    const Graphics_Display_Functions *funcs = &g_sCrystalfontz128x128_funcs;
+    Graphics_Rectangle rect = { x0, y0, x1, y1 };
+    ST7735_Counters counters;
+    int16_t x, y;
+    uint16_t expected, shown;
+    int bad = 0;
+
+    funcs->pfnClearDisplay(display, WHITE);
+    funcs->pfnFlush(display);
+
+    ST7735_resetCounters();
+    funcs->pfnRectFill(display, &rect, BLUE);
+    funcs->pfnFlush(display);
+    ST7735_getCounters(&counters);
+
+    if (counters.ulOverruns || counters.ulHidden)
+    {
+        printf("%d,%d-%d,%d: %u pixels past the window, %u hidden\n",
+               x0, y0, x1, y1, counters.ulOverruns, counters.ulHidden);
+        bad++;
+    }
+
+    for (y = 0; y < LCD_VERTICAL_MAX; y++)
+    {
+        for (x = 0; x < LCD_HORIZONTAL_MAX; x++)
+        {
+            expected = (x >= x0 && x <= x1 && y >= y0 && y <= y1) ? BLUE : WHITE;
+            shown = ST7735_getScreenPixel(x, y);
+            if (!SAME_COLOR(shown, expected))
+            {
+                if (!bad)
+                {
+                    printf("%d,%d-%d,%d: first wrong pixel at %d,%d: %04x, not %04x\n",
+                           x0, y0, x1, y1, x, y, shown, expected);
+                }
+                bad++;
+            }
+        }
+    }
+
+    return bad;
+}
+
+int main(void)
+{
+    int bad = 0;
+    uint8_t orientation;
+
+    Crystalfontz128x128_Init();
+
+    for (orientation = LCD_ORIENTATION_UP; orientation <= LCD_ORIENTATION_RIGHT; orientation++)
+    {
+        Crystalfontz128x128_SetOrientation(orientation);
+
+        bad += check(0, 0, 0, 0);
+        bad += check(127, 127, 127, 127);
+        bad += check(10, 20, 40, 30);
+        bad += check(3, 5, 4, 90);
+        bad += check(0, 64, 127, 64);
+        bad += check(0, 0, 127, 127);
+    }
+
+    printf("%s\n", bad ? "FAIL" : "ok");
+    return bad != 0;
+}
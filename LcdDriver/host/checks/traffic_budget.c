@@ -0,0 +1,115 @@
+//*****************************************************************************
+//
+// traffic_budget.c - Checks the SPI traffic of each primitive against a
+//                    budget, so an optimization that is undone shows up.
+//
+// Every primitive is drawn once through g_sST7735_countingFuncs, with the
+// address window forgotten beforehand so it is always sent.  The budgets
+// are the bytes (commands included) and DC toggles of the driver as it
+// stands, without a framebuffer or display list; lower them when a change
+// saves traffic.  Build and run it with LcdDriver/host/Makefile.
+//
+//*****************************************************************************
+
+#include <stdio.h>
+#include "Crystalfontz128x128_ST7735.h"
+#include "host/ST7735_Emulator.h"
+
+#if LCD_BUFFERED_DRAWING
+#error "the budgets are for drawing straight to the panel"
+#endif
+
+typedef struct
+{
+    const char *pcName;
+    ST7735_Primitive ePrimitive;
+    // At 16 and 12 bits per pixel
+    uint32_t ulBytes[2];
+    uint32_t ulDcToggles;
+} Budget;
+
+#if LCD_COLOR_DEPTH == 12
+#define DEPTH   1
+#else
+#define DEPTH   0
+#endif
+
+static const Budget budgets[] =
+{
+    { "PixelDraw",          ST7735_PIXEL_DRAW,          {  13,  13 },  6 },
+    { "PixelDrawMultiple",  ST7735_PIXEL_DRAW_MULTIPLE, { 267, 203 },  6 },
+    { "LineDrawH",          ST7735_LINE_DRAW_H,         { 211, 161 },  6 },
+    { "LineDrawV",          ST7735_LINE_DRAW_V,         { 211, 161 },  6 },
+    { "RectFill",           ST7735_RECT_FILL,           { 693, 523 },  6 },
+    { "ClearDisplay",       ST7735_CLEAR_SCREEN,        { 32779, 24587 }, 6 }
+};
+
+static const Graphics_Display *display = &g_sCrystalfontz128x128;
+
+// Draws one of each primitive
+static void draw(const Graphics_Display_Functions *funcs, ST7735_Primitive ePrimitive)
+{
+    static const uint32_t palette[2] = { 0x0000, 0xFFFF };
+    static const uint8_t row[16] = { 0xF0, 0x0F, 0xAA, 0x55, 0xFF, 0x00, 0x3C, 0xC3,
+                                     0xF0, 0x0F, 0xAA, 0x55, 0xFF, 0x00, 0x3C, 0xC3 };
+    Graphics_Rectangle rect = { 10, 20, 40, 30 };
+
+    switch (ePrimitive)
+    {
+        case ST7735_PIXEL_DRAW:
+            funcs->pfnPixelDraw(display, 64, 64, 0xF800);
+            break;
+        case ST7735_PIXEL_DRAW_MULTIPLE:
+            funcs->pfnPixelDrawMultiple(display, 0, 10, 0, 128, 1, row, palette);
+            break;
+        case ST7735_LINE_DRAW_H:
+            funcs->pfnLineDrawH(display, 0, 99, 50, 0x07E0);
+            break;
+        case ST7735_LINE_DRAW_V:
+            funcs->pfnLineDrawV(display, 50, 0, 99, 0x07E0);
+            break;
+        case ST7735_RECT_FILL:
+            funcs->pfnRectFill(display, &rect, 0x001F);
+            break;
+        case ST7735_CLEAR_SCREEN:
+            funcs->pfnClearDisplay(display, 0xFFFF);
+            break;
+        default:
+            break;
+    }
+    funcs->pfnFlush(display);
+}
+
+int main(void)
+{
+    const Graphics_Display_Functions *funcs = &g_sST7735_countingFuncs;
+    ST7735_Counters counters;
+    uint32_t calls;
+    unsigned i;
+    int bad = 0;
+
+    Crystalfontz128x128_Init();
+    Crystalfontz128x128_SetOrientation(LCD_ORIENTATION_UP);
+
+    for (i = 0; i < sizeof(budgets) / sizeof(budgets[0]); i++)
+    {
+        const Budget *budget = &budgets[i];
+
+        Crystalfontz128x128_InvalidateDrawFrame();
+        ST7735_resetCounters();
+        draw(funcs, budget->ePrimitive);
+        ST7735_getPrimitiveCounters(budget->ePrimitive, &counters, &calls);
+
+        printf("%-18s %6u bytes (budget %6u), %3u DC toggles (budget %3u)\n",
+               budget->pcName, counters.ulBytes, budget->ulBytes[DEPTH],
+               counters.ulDcToggles, budget->ulDcToggles);
+        if ((counters.ulBytes > budget->ulBytes[DEPTH]) ||
+            (counters.ulDcToggles > budget->ulDcToggles))
+        {
+            bad++;
+        }
+    }
+
+    printf("%s\n", bad ? "FAIL" : "ok");
+    return bad != 0;
+}
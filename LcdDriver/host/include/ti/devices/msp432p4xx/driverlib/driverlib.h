@@ -0,0 +1,40 @@
+//*****************************************************************************
+//
+// driverlib.h - Stand-in for MSP432 driverlib when the display driver is
+//               built on a PC against ST7735_Emulator.
+//
+// Only what the display driver and its HAL header use is here.  The GPIO
+// calls go to the emulated HAL, which watches the panel's reset line.
+//
+//*****************************************************************************
+
+#ifndef __HOST_DRIVERLIB_H__
+#define __HOST_DRIVERLIB_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define GPIO_PORT_P1                    1
+#define GPIO_PORT_P2                    2
+#define GPIO_PORT_P3                    3
+#define GPIO_PORT_P4                    4
+#define GPIO_PORT_P5                    5
+#define GPIO_PORT_P6                    6
+
+#define GPIO_PIN0                       (0x0001)
+#define GPIO_PIN1                       (0x0002)
+#define GPIO_PIN2                       (0x0004)
+#define GPIO_PIN3                       (0x0008)
+#define GPIO_PIN4                       (0x0010)
+#define GPIO_PIN5                       (0x0020)
+#define GPIO_PIN6                       (0x0040)
+#define GPIO_PIN7                       (0x0080)
+
+#define GPIO_PRIMARY_MODULE_FUNCTION    (0x01)
+
+extern void GPIO_setOutputHighOnPin(uint_fast8_t selectedPort,
+                                    uint_fast16_t selectedPins);
+extern void GPIO_setOutputLowOnPin(uint_fast8_t selectedPort,
+                                   uint_fast16_t selectedPins);
+
+#endif /* __HOST_DRIVERLIB_H__ */
@@ -0,0 +1,186 @@
+#include <ti/devices/msp432p4xx/driverlib/driverlib.h>
+#include "adc_stream.h"
+#include "dma_table.h"
+#include "irq_priority.h"
+#include "sleep_manager.h"
+
+#define ADC_DMA_CHANNEL     DMA_CH7_ADC14
+#define ADC_DMA_CHANNEL_NUM 7
+#define ADC_DMA_INT         DMA_INT2
+#define ADC_DMA_INT_NUM     INT_DMA_INT2
+
+#define ACLK_HZ             32768
+
+// ADC_CHANNEL_COUNT, which #if cannot see
+#define SEQUENCE_LENGTH     5
+
+// ACLK ticks between two conversions, rounded to the nearest
+#define CONVERSION_RATE_HZ  (ADC_STREAM_RATE_HZ * SEQUENCE_LENGTH)
+#define TRIGGER_PERIOD      ((ACLK_HZ + CONVERSION_RATE_HZ / 2) / CONVERSION_RATE_HZ)
+
+#if TRIGGER_PERIOD < 2
+#error "ADC_STREAM_RATE_HZ is too high for ACLK"
+#endif
+
+#define RING_SLOTS          (2 * ADC_STREAM_BLOCK_SAMPLES)
+
+// Where each channel is on the BoosterPack: P6.0, P4.4, P6.1, P4.0, P4.2
+static const uint32_t inputs[ADC_CHANNEL_COUNT] = {
+    ADC_INPUT_A15,
+    ADC_INPUT_A9,
+    ADC_INPUT_A14,
+    ADC_INPUT_A13,
+    ADC_INPUT_A11
+};
+
+static const uint32_t memories[ADC_CHANNEL_COUNT] = {
+    ADC_MEM0, ADC_MEM1, ADC_MEM2, ADC_MEM3, ADC_MEM4
+};
+
+// Two blocks, one after the other
+static AdcSample ring[RING_SLOTS];
+
+static EventQueue *events;
+
+// The slot of the control structure that finishes next, and whether that
+// is the alternate one. The other structure writes the slot after it.
+static unsigned finishingSlot;
+static bool alternateNext;
+
+static const AdcSample *volatile readyBlock = ring;
+static volatile uint32_t late = 0;
+
+// Points a control structure at a slot. The results are 32-bit registers,
+// of which the DMA reads the lower half.
+static void arm(uint32_t structure, unsigned slot)
+{
+    DMA_setChannelTransfer(structure | ADC_DMA_CHANNEL, UDMA_MODE_PINGPONG,
+                           (void *) &ADC14->MEM[0], ring[slot].value,
+                           ADC_CHANNEL_COUNT);
+}
+
+// Starts the ring over at its first slot
+static void armRing()
+{
+    DMA_disableChannelAttribute(ADC_DMA_CHANNEL, UDMA_ATTR_ALTSELECT);
+    arm(UDMA_PRI_SELECT, 0);
+    arm(UDMA_ALT_SELECT, 1);
+    finishingSlot = 0;
+    alternateNext = false;
+}
+
+// Runs once for every sample, at IRQ_LEVEL_ADC_DMA. It has until the next
+// sequence ends to rearm the structure that finished; by then the DMA has
+// moved on to the other one.
+void DMA_INT2_IRQHandler()
+{
+    unsigned done = finishingSlot;
+
+    DMA_clearInterruptFlag(ADC_DMA_CHANNEL_NUM);
+
+    // Both structures finished, and the channel stopped: lose the block
+    if (!DMA_isChannelEnabled(ADC_DMA_CHANNEL_NUM)) {
+        late++;
+        armRing();
+        DMA_enableChannel(ADC_DMA_CHANNEL_NUM);
+        return;
+    }
+
+    arm(alternateNext ? UDMA_ALT_SELECT : UDMA_PRI_SELECT, (done + 2) % RING_SLOTS);
+    alternateNext = !alternateNext;
+    finishingSlot = (done + 1) % RING_SLOTS;
+
+    if (finishingSlot % ADC_STREAM_BLOCK_SAMPLES == 0) {
+        readyBlock = &ring[done + 1 - ADC_STREAM_BLOCK_SAMPLES];
+        EventQueue_push(events, EVENT_ADC_BLOCK_READY);
+    }
+}
+
+void AdcStream_init(EventQueue *queue)
+{
+    int channel;
+
+    events = queue;
+
+    GPIO_setAsPeripheralModuleFunctionInputPin(GPIO_PORT_P6, GPIO_PIN0 | GPIO_PIN1,
+                                               GPIO_TERTIARY_MODULE_FUNCTION);
+    GPIO_setAsPeripheralModuleFunctionInputPin(GPIO_PORT_P4, GPIO_PIN0 | GPIO_PIN2 | GPIO_PIN4,
+                                               GPIO_TERTIARY_MODULE_FUNCTION);
+
+    // MODOSC does not depend on the clock profile
+    ADC14_enableModule();
+    ADC14_initModule(ADC_CLOCKSOURCE_ADCOSC, ADC_PREDIVIDER_1, ADC_DIVIDER_1, ADC_NOROUTE);
+    for (channel = 0; channel < ADC_CHANNEL_COUNT; channel++) {
+        ADC14_configureConversionMemory(memories[channel], ADC_VREFPOS_AVCC_VREFNEG_VSS,
+                                        inputs[channel], ADC_NONDIFFERENTIAL_INPUTS);
+    }
+
+    // Each rising edge of TA1.1 samples and converts one channel; with
+    // automatic iteration, the first edge would start conversions that
+    // never stop
+    ADC14_setSampleHoldTrigger(ADC_TRIGGER_SOURCE3, false);
+    ADC14_setSampleHoldTime(ADC_PULSE_WIDTH_32, ADC_PULSE_WIDTH_32);
+    ADC14_enableSampleTimer(ADC_MANUAL_ITERATION);
+
+    // TA1.1 in reset/set mode rises once per period; the timer is started
+    // by AdcStream_start()
+    TIMER_A1->CTL = TIMER_A_CTL_TASSEL_1 | TIMER_A_CTL_CLR;
+    TIMER_A1->CCR[0] = TRIGGER_PERIOD - 1;
+    TIMER_A1->CCR[1] = TRIGGER_PERIOD / 2;
+    TIMER_A1->CCTL[1] = TIMER_A_CCTLN_OUTMOD_7;
+
+    // ADC14 requests the DMA at the end of each sequence, for all five
+    // results at once
+    DmaTable_init();
+    DMA_assignChannel(ADC_DMA_CHANNEL);
+    DMA_disableChannelAttribute(ADC_DMA_CHANNEL,
+                                UDMA_ATTR_ALTSELECT | UDMA_ATTR_USEBURST |
+                                UDMA_ATTR_HIGH_PRIORITY | UDMA_ATTR_REQMASK);
+    DMA_setChannelControl(UDMA_PRI_SELECT | ADC_DMA_CHANNEL,
+                          UDMA_SIZE_16 | UDMA_SRC_INC_32 | UDMA_DST_INC_16 | UDMA_ARB_8);
+    DMA_setChannelControl(UDMA_ALT_SELECT | ADC_DMA_CHANNEL,
+                          UDMA_SIZE_16 | UDMA_SRC_INC_32 | UDMA_DST_INC_16 | UDMA_ARB_8);
+
+    DMA_assignInterrupt(ADC_DMA_INT, ADC_DMA_CHANNEL_NUM);
+    DMA_clearInterruptFlag(ADC_DMA_CHANNEL_NUM);
+    IrqPriority_enableInterrupt(ADC_DMA_INT_NUM, IRQ_LEVEL_ADC_DMA);
+}
+
+void AdcStream_start()
+{
+    armRing();
+    DMA_enableChannel(ADC_DMA_CHANNEL_NUM);
+
+    SleepManager_blockLPM3(SLEEP_BLOCKER_ADC);
+
+    // The sequence can only be set while conversions are disabled
+    ADC14_configureMultiSequenceMode(ADC_MEM0, ADC_MEM4, true);
+    ADC14_enableConversion();
+
+    TIMER_A1->CTL = TIMER_A_CTL_TASSEL_1 | TIMER_A_CTL_MC__UP | TIMER_A_CTL_CLR;
+}
+
+void AdcStream_stop()
+{
+    TIMER_A1->CTL = TIMER_A_CTL_TASSEL_1 | TIMER_A_CTL_MC__STOP;
+
+    // Clearing ENC alone would wait for the end of the sequence, which with
+    // the timer stopped never comes; going back to single-channel mode as
+    // well stops it at once
+    ADC14->CTL0 &= ~(ADC14_CTL0_CONSEQ_MASK | ADC14_CTL0_ENC);
+
+    DMA_disableChannel(ADC_DMA_CHANNEL_NUM);
+    DMA_clearInterruptFlag(ADC_DMA_CHANNEL_NUM);
+
+    SleepManager_unblockLPM3(SLEEP_BLOCKER_ADC);
+}
+
+const AdcSample *AdcStream_readyBlock()
+{
+    return readyBlock;
+}
+
+uint32_t AdcStream_lateCount()
+{
+    return late;
+}
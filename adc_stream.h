@@ -0,0 +1,76 @@
+// Joystick and accelerometer sampling on the BOOSTXL-EDUMKII BoosterPack
+//
+// ADC14 converts the five analog channels in a repeated sequence, one
+// conversion on each rising edge of TA1.1, so the CPU starts none of them.
+// At the end of every sequence the uDMA (channel 7) copies the five results
+// into the next slot of a ring of two blocks, alternating between its
+// primary and alternate control structures (ping-pong mode). A structure
+// only covers one sample, since the results always come from the same five
+// registers, so its interrupt runs once per sample, at IRQ_LEVEL_ADC_DMA,
+// and only points the structure that just finished at the slot after the
+// other one. Each time a block fills up, an EVENT_ADC_BLOCK_READY is pushed,
+// and main reads the whole block while the DMA fills the other one; main
+// never wakes up for a single sample.
+//
+// TA1 runs from ACLK, so the rate does not change with the clock profile.
+// ADC14 does not run in LPM3, which is blocked while streaming.
+
+#ifndef ADC_STREAM_H_
+#define ADC_STREAM_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "event_queue.h"
+
+// Build with USE_ADC_STREAM=1 to have the example stream the sensors
+#ifndef USE_ADC_STREAM
+#define USE_ADC_STREAM 0
+#endif
+
+// Samples of every channel per second. The conversions run five times as
+// fast, at the nearest rate ACLK divides down to.
+#ifndef ADC_STREAM_RATE_HZ
+#define ADC_STREAM_RATE_HZ 100
+#endif
+
+// Samples per block, so blocks per second is ADC_STREAM_RATE_HZ divided by
+// this
+#ifndef ADC_STREAM_BLOCK_SAMPLES
+#define ADC_STREAM_BLOCK_SAMPLES 16
+#endif
+
+// In the order of the sequence
+typedef enum {
+    ADC_JOYSTICK_X,
+    ADC_JOYSTICK_Y,
+    ADC_ACCEL_X,
+    ADC_ACCEL_Y,
+    ADC_ACCEL_Z,
+    ADC_CHANNEL_COUNT
+} AdcChannel;
+
+// One conversion of every channel, 14-bit, 0 to 16383 over 0 to AVCC
+typedef struct {
+    uint16_t value[ADC_CHANNEL_COUNT];
+} AdcSample;
+
+// Configures the pins, ADC14, TA1 and the DMA channel. Block events go to
+// the given queue, whose only producer is the DMA interrupt. Call once,
+// before AdcStream_start().
+void AdcStream_init(EventQueue *queue);
+
+// Starts or stops sampling. A stop throws away the block being filled.
+void AdcStream_start();
+void AdcStream_stop();
+
+// Returns the block the last EVENT_ADC_BLOCK_READY was for. It holds
+// ADC_STREAM_BLOCK_SAMPLES samples, oldest first, and stays valid for one
+// block period, until the DMA comes back to it.
+const AdcSample *AdcStream_readyBlock();
+
+// Number of times the DMA interrupt came so late that both control
+// structures had finished, losing the samples converted in between. Should
+// stay 0.
+uint32_t AdcStream_lateCount();
+
+#endif /* ADC_STREAM_H_ */
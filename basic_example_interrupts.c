@@ -1,10 +1,23 @@
 // This application illustrates a simple use of interrupts for both GPIO and Timer32
-// A transition on LB1 turns LL1 on for about 2 seconds
+// A press of S1, once debounced, turns LL1 on for about 2 seconds
 
 #include <ti/devices/msp432p4xx/driverlib/driverlib.h>
-
-// Based on system clock of 3MHz and prescaler of 1, this is a 2000ms wait
-#define TIMER_WAIT 6000000
+#include "adc_stream.h"
+#include "benchmarks/benchmark.h"
+#include "buttons.h"
+#include "event_queue.h"
+#include "profiler.h"
+#include "ramfunc.h"
+#include "scheduler.h"
+#include "sleep_manager.h"
+#include "sw_timer.h"
+#include "timestamp.h"
+#include "vector_table.h"
+
+// The LED timeout, in microseconds. It is one of the software timers sharing Timer32_0.
+// Timer32 stops in LPM3, so while the timeout runs the processor only sleeps in LPM0;
+// with LL1 lit, the LED draws far more current than the difference between the two.
+#define TIMER_WAIT 2000000
 
 // This function initializes all the peripherals
 void initialize();
@@ -14,78 +27,142 @@ void TurnOff_LL1();
 void TurnOn_LLG();
 void TurnOff_LLG();
 
-// The global variables used by the ISRs
+// The queues the ISRs use to tell main what happened
+// Each ISR has its own queue, so an event is never merged with or lost to another one,
+// and the ISRs never have to disable interrupts to add to them.
 
-// A boolean variable that is true when a high-to-low transition is sensed on S1
-volatile bool S1modifiedFlag = false;
+// Receives the debounced presses, releases, long presses and double taps of S1 and S2
+EventQueue buttonEvents;
 
-// A boolean variable that is true when Timer32 is expired
-volatile bool TimerExpiredFlag = false;
+// Receives an event every time the 2-second wait is over
+EventQueue timerEvents;
 
+#if USE_ADC_STREAM
+// Receives an event for every block of joystick and accelerometer samples
+EventQueue sensorEvents;
 
-// The ISR for port 1 (all of port 1, not any specific pin)
-// Hold the control key on your keyboard and click on the name of this function to see where it takes you
-// We did not choose the name of this function. Any time a port 1 interrupt happens this function is called automoatically.
-void PORT1_IRQHandler() {
+// The average of each channel over the last block, to watch in the debugger
+AdcSample sensorAverage;
+#endif
 
-    // In our case on only S1 (attached to Pin1) can provide interrupt.
-    // However, this is not true for all programs, so in general, you have to check
-    // to make sure what pin created the interrupt
-    if (GPIO_getInterruptStatus(GPIO_PORT_P1,
-                                GPIO_PIN1))
-        S1modifiedFlag = true;
+// The software timer that turns LL1 off
+SwTimer ledTimer;
 
-    // The very critical step to make sure once we leave ISR, we don't come back to ISR again.
-    // This tells the GPIO, the CPU has heard the interrupt and it should clear it.
-    GPIO_clearInterruptFlag(GPIO_PORT_P1,
-                            GPIO_PIN1);
-}
+// The tasks that handle the events in each queue
+// The buttons come first: if both have events waiting, the button events are handled first.
+SchedulerTask buttonTask;
+SchedulerTask timerTask;
+#if USE_ADC_STREAM
+SchedulerTask sensorTask;
+#endif
+
+#define BUTTON_TASK_PRIORITY 0
+#define TIMER_TASK_PRIORITY  1
+#define SENSOR_TASK_PRIORITY 2
+
+void handleButtonEvent(const Event *event);
+void handleTimerEvent(const Event *event);
+void handleSensorEvent(const Event *event);
+void startTimer();
 
-// This is also an ISR, but we picked our own name.
-// Since we picked the name, we have to register this function to become an official ISR
-void TimerExpired()
+
+// This is not an ISR, but the software timer service calls it from its Timer32 ISR.
+// We pass it to SwTimer_start(), so we could have picked any name.
+RAMFUNC void TimerExpired(void *arg)
 {
-    // We use this global variable to communicate with the main
-    TimerExpiredFlag = true;
+    PROFILE_BEGIN(PROFILE_TIMER_EXPIRED);
+
+    // We use this queue to communicate with the main
+    EventQueue_push(&timerEvents, EVENT_TIMER_EXPIRED);
 
-    // We tell the Timer32 to remove the interrupt as we already handled it.
-    Timer32_clearInterruptFlag(TIMER32_0_BASE);
+    PROFILE_END(PROFILE_TIMER_EXPIRED);
 }
 
 
 int main(void)
 {
+#if BENCHMARK != BENCHMARK_NONE
+    // Benchmark builds run the selected benchmark instead of the example
+    Benchmark_run();
+#endif
 
     initialize();
 
+#if SLEEP_ON_EXIT
+    // From here on everything runs in interrupts. The scheduler handles the events from
+    // PendSV, and once the last handler returns the core goes straight back to sleep,
+    // without coming back to main to toggle LLG, look at the queues and sleep again.
+    // LLG stays off in this mode.
+    SleepManager_sleepOnExit();
+#else
     while (1) {
-        // Enters the Low Power Mode 0 - the processor is asleep and only responds to interrupts
+        // Handle one event, from the most urgent task that has one, and look again.
+        // Popping an event removes it, so the next time we look we don't see it again.
+        if (Scheduler_dispatch())
+            continue;
+
+        // Enters the deepest Low Power Mode allowed, normally LPM3 - the processor is asleep and only responds to interrupts
+        // It does not go to sleep at all if an event came in since we last looked at the queues.
         // LLG signifies asleep processor. During runtime, it appears the processor is always asleep
         // Debugging shows that the processor does wake up, but we blink and we miss it!
         TurnOn_LLG();
-        PCM_gotoLPM0();
+        SleepManager_sleep(Scheduler_pending);
         TurnOff_LLG();
+    }
+#endif
+}
 
-        if (S1modifiedFlag) {
-            TurnOn_LL1();
+// The scheduler calls this for every event in buttonEvents
+void handleButtonEvent(const Event *event)
+{
+    switch (event->type) {
+    case EVENT_S1_PRESSED:
+        TurnOn_LL1();
 
-            // This is important. Otherwise, the next time we enter the loop, we think there has been an interrupt
-            S1modifiedFlag = false;
+        // start the 2-second timer. The timer is configured to give interrupts
+        startTimer();
+        break;
 
-            // start the 2-second timer. The timer is configured to give interrupts
-            Timer32_setCount(TIMER32_0_BASE, TIMER_WAIT);
-            Timer32_startTimer(TIMER32_0_BASE, true);
-        }
+    default:
+        // The other button events are not used by this example
+        break;
+    }
+}
 
-        if (TimerExpiredFlag) {
-            TurnOff_LL1();
+// The scheduler calls this for every event in timerEvents
+void handleTimerEvent(const Event *event)
+{
+    // The button task comes first, so a press that came in with this expiry has already
+    // been handled and restarted the timer. Then the event is stale: LL1 stays on.
+    if (SwTimer_isActive(&ledTimer))
+        return;
 
-            // This is important. Otherwise, we will think the timer recently expired.
-            TimerExpiredFlag = false;
-        }
+    TurnOff_LL1();
+}
 
+#if USE_ADC_STREAM
+// The scheduler calls this for every block in sensorEvents
+void handleSensorEvent(const Event *event)
+{
+    const AdcSample *block = AdcStream_readyBlock();
+    uint32_t sum;
+    int channel, sample;
+
+    for (channel = 0; channel < ADC_CHANNEL_COUNT; channel++) {
+        sum = 0;
+        for (sample = 0; sample < ADC_STREAM_BLOCK_SAMPLES; sample++)
+            sum += block[sample].value[channel];
+        sensorAverage.value[channel] = sum / ADC_STREAM_BLOCK_SAMPLES;
     }
 }
+#endif
+
+// Starts, or restarts, the 2-second wait
+void startTimer()
+{
+    // A one-shot timer: it calls TimerExpired() once, TIMER_WAIT from now
+    SwTimer_start(&ledTimer, TIMER_WAIT, 0, TimerExpired, NULL);
+}
 
 void initLEDs() {
 
@@ -97,42 +174,21 @@ void initLEDs() {
     TurnOff_LLG();
 }
 
-void initLB1() {
-    // Initializing S1 (switch 1 or button 1),
-    // which is on Pin1 of Port 1 (from page 37 of the Launchpad User Guide)
-    GPIO_setAsInputPinWithPullUpResistor (GPIO_PORT_P1, GPIO_PIN1);
-
-    GPIO_clearInterruptFlag(GPIO_PORT_P1,
-                            GPIO_PIN1);
-
-    // enable interrupt on port 1, pin 1
-    GPIO_enableInterrupt(GPIO_PORT_P1,
-                         GPIO_PIN1);
-
-    // the interrupt is triggered on high to low transition (tapping)
-    GPIO_interruptEdgeSelect(GPIO_PORT_P1,
-                             GPIO_PIN1,
-                             GPIO_HIGH_TO_LOW_TRANSITION);
-
-    // enable the port 1 interrupt
-    Interrupt_enableInterrupt(INT_PORT1);
-
+void initButtons() {
+    // Initializing S1 (switch 1 or button 1) and S2,
+    // which are on Pin1 and Pin4 of Port 1 (from page 37 of the Launchpad User Guide)
+    // The buttons module sets up their pull-ups and port 1 interrupts,
+    // and uses software timers to debounce them.
+    // The ISR for port 1 (all of port 1, not any specific pin) is PORT1_IRQHandler in gpio_irq.c.
+    // We did not choose its name: any time a port 1 interrupt happens it is called automatically.
+    // It reads P1IV, which tells it which pin created the interrupt and clears that pin's flag,
+    // and calls the function the buttons module registered for the pin.
+    Buttons_init(&buttonEvents);
 }
 
 void initTimer(){
-    // Initialize the timers needed for debouncing
-    Timer32_initModule(TIMER32_0_BASE, // There are two timers, we are using the one with the index 0
-                       TIMER32_PRESCALER_1, // The prescaler value is 1; The clock is not divided before feeding the counter
-                       TIMER32_32BIT, // The counter is used in 32-bit mode; the alternative is 16-bit mode
-                       TIMER32_PERIODIC_MODE); //This options is irrelevant for a one-shot timer
-
-    // register the TimerExpired() function as the ISR for Timer32_0
-    Timer32_registerInterrupt(INT_T32_INT1, TimerExpired);
-
-    Timer32_clearInterruptFlag(TIMER32_0_BASE);
-
-    Interrupt_enableInterrupt(INT_T32_INT1);
-
+    // The software timers take over Timer32_0 and register their own ISR for it
+    SwTimer_init();
 }
 
 void initialize()
@@ -140,9 +196,29 @@ void initialize()
 
     WDT_A_hold(WDT_A_BASE);
 
+    // Start the clock used to timestamp events before any ISR can push one
+    Timestamp_init();
+
+    // Does nothing unless the project is built with PROFILING=1
+    PROFILE_INIT();
+
+    Scheduler_init();
+    Scheduler_addTask(&buttonTask, BUTTON_TASK_PRIORITY, &buttonEvents, handleButtonEvent);
+    Scheduler_addTask(&timerTask, TIMER_TASK_PRIORITY, &timerEvents, handleTimerEvent);
+#if USE_ADC_STREAM
+    Scheduler_addTask(&sensorTask, SENSOR_TASK_PRIORITY, &sensorEvents, handleSensorEvent);
+#endif
+
     initLEDs();
-    initLB1();
     initTimer();
+    initButtons();
+
+#if USE_ADC_STREAM
+    // The joystick and accelerometer are sampled by the ADC14, a TimerA and the DMA on
+    // their own; main only hears about every full block. This keeps the device in LPM0.
+    AdcStream_init(&sensorEvents);
+    AdcStream_start();
+#endif
 }
 
 void TurnOn_LL1()
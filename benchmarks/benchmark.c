@@ -0,0 +1,104 @@
+// Common setup and timing for the benchmarks in this folder
+
+#include <ti/devices/msp432p4xx/driverlib/driverlib.h>
+#include "LcdDriver/HAL_MSP_EXP432P401R_Crystalfontz128x128_ST7735.h"
+#include "benchmarks/benchmark.h"
+#include "clock_profile.h"
+
+void Benchmark_run(void)
+{
+    WDT_A_hold(WDT_A_BASE);
+
+    // The benchmarks run at full speed. The LCD's SPI clock is kept in step
+    // in case a benchmark changes it after initializing the display.
+    ClockProfile_set(CLOCK_PROFILE_48MHZ);
+    ClockProfile_subscribe(HAL_LCD_updateSpiClock);
+
+#if BENCHMARK == BENCHMARK_LCD_TEXT
+    Benchmark_lcdText();
+#elif BENCHMARK == BENCHMARK_LATENCY
+    Benchmark_latency();
+#elif BENCHMARK == BENCHMARK_LCD_THROUGHPUT
+    Benchmark_lcdThroughput();
+#endif
+
+    // Results are ready; stop here for the debugger
+    while (1) {
+        PCM_gotoLPM0();
+    }
+}
+
+void Benchmark_startCycles(void)
+{
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CYCCNT = 0;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+}
+
+uint32_t Benchmark_cycles(void)
+{
+    return DWT->CYCCNT;
+}
+
+uint32_t Benchmark_perSecond(uint32_t count, uint32_t cycles)
+{
+    if (cycles == 0)
+        return 0;
+
+    return (uint32_t)(((uint64_t)count * SystemCoreClock) / cycles);
+}
+
+void Benchmark_initUart(void)
+{
+    // Oversampling mode: UCBRx = N / 16 and UCBRFx = N % 16, with
+    // N = SMCLK / baud rate. The fraction left over is less than one SMCLK
+    // cycle per bit, so UCBRSx is left at 0.
+    uint32_t n = CS_getSMCLK() / 115200;
+    eUSCI_UART_Config config = {
+        EUSCI_A_UART_CLOCKSOURCE_SMCLK,
+        n / 16,
+        n % 16,
+        0,
+        EUSCI_A_UART_NO_PARITY,
+        EUSCI_A_UART_LSB_FIRST,
+        EUSCI_A_UART_ONE_STOP_BIT,
+        EUSCI_A_UART_MODE,
+        EUSCI_A_UART_OVERSAMPLING_BAUDRATE_GENERATION
+    };
+
+    GPIO_setAsPeripheralModuleFunctionInputPin(GPIO_PORT_P1,
+                                               GPIO_PIN2 | GPIO_PIN3,
+                                               GPIO_PRIMARY_MODULE_FUNCTION);
+
+    UART_initModule(EUSCI_A0_BASE, &config);
+    UART_enableModule(EUSCI_A0_BASE);
+}
+
+void Benchmark_print(const char *string)
+{
+    while (*string) {
+        // Terminals want a carriage return before every line feed
+        if (*string == '\n')
+            UART_transmitData(EUSCI_A0_BASE, '\r');
+        UART_transmitData(EUSCI_A0_BASE, *string++);
+    }
+}
+
+void Benchmark_printNumber(uint32_t number)
+{
+    char digits[11];
+    int i = sizeof(digits) - 1;
+
+    digits[i] = '\0';
+    do {
+        digits[--i] = '0' + number % 10;
+        number /= 10;
+    } while (number != 0);
+
+    Benchmark_print(&digits[i]);
+}
+
+void Benchmark_waitUart(void)
+{
+    while (UART_queryStatusFlags(EUSCI_A0_BASE, EUSCI_A_UART_BUSY));
+}
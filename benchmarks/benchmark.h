@@ -0,0 +1,51 @@
+// Benchmarks that can be built in place of the example application.
+//
+// Pick one by defining BENCHMARK in the project's predefined symbols, for
+// example BENCHMARK=BENCHMARK_LCD_TEXT.  main() then calls Benchmark_run()
+// instead of running the example.  Results are left in global variables,
+// to be read with the debugger once the benchmark reaches its final loop,
+// or printed on the LaunchPad's backchannel UART (115200 baud, 8N1).
+
+#ifndef BENCHMARKS_BENCHMARK_H_
+#define BENCHMARKS_BENCHMARK_H_
+
+#include <stdint.h>
+
+#define BENCHMARK_NONE          0
+#define BENCHMARK_LCD_TEXT      1
+#define BENCHMARK_LATENCY       2
+#define BENCHMARK_LCD_THROUGHPUT 3
+
+#ifndef BENCHMARK
+#define BENCHMARK BENCHMARK_NONE
+#endif
+
+// Runs the benchmark selected by BENCHMARK. Does not return.
+void Benchmark_run(void);
+
+// Starts the DWT cycle counter from zero
+void Benchmark_startCycles(void);
+
+// Returns the number of core cycles since Benchmark_startCycles()
+uint32_t Benchmark_cycles(void);
+
+// Converts a count of events that took the given number of core cycles
+// into events per second
+uint32_t Benchmark_perSecond(uint32_t count, uint32_t cycles);
+
+// Sets up eUSCI_A0 on P1.2/P1.3, the backchannel UART, for the current
+// SMCLK. Call again after every clock change.
+void Benchmark_initUart(void);
+
+// Sends a string or an unsigned decimal number on the UART
+void Benchmark_print(const char *string);
+void Benchmark_printNumber(uint32_t number);
+
+// Waits until the UART has sent everything, before a clock change or LPM3
+void Benchmark_waitUart(void);
+
+void Benchmark_lcdText(void);
+void Benchmark_latency(void);
+void Benchmark_lcdThroughput(void);
+
+#endif /* BENCHMARKS_BENCHMARK_H_ */
@@ -0,0 +1,296 @@
+// Interrupt latency and wake-up time benchmark (BENCHMARK_LATENCY)
+//
+// Needs a jumper from P2.4 (TA0.1) to P1.7. TA0 toggles TA0.1 at a known
+// count, and the edge comes back in on P1.7 as a port 1 interrupt. Both
+// the ISR and main snapshot TA0R with a software capture, to measure:
+//
+//  - edge to ISR: from the edge to PORT1_IRQHandler, after its prologue
+//  - edge to resume: from the edge to main again, after the ISR; when main
+//    was asleep, that is the code right after PCM_gotoLPM0/3()
+//
+// for every clock profile, with main spinning (active), in LPM0 and in
+// LPM3, and with the ISR checking and clearing the flag through driverlib
+// or through the port registers. The DWT counts the cycles the ISR spends on
+// the flag in each case.
+//
+// TA0 runs from SMCLK, except in LPM3 where only ACLK is left, so the
+// LPM3 results are in 32768Hz ticks. Captures happen on the timer clock
+// edge after the request, so every result rounds up by up to one tick.
+// Results are printed on the UART with a histogram of each.
+
+#include <ti/devices/msp432p4xx/driverlib/driverlib.h>
+#include "benchmarks/benchmark.h"
+#include "clock_profile.h"
+#include "irq_priority.h"
+
+#if BENCHMARK == BENCHMARK_LATENCY
+
+// Edges measured for each case
+#define LATENCY_SAMPLES     256
+
+// Most histogram rows printed for each result
+#define LATENCY_BINS        12
+
+// Ticks from arming an edge to the edge. Main must be asleep by then.
+#define LEAD_SMCLK_TICKS    400
+#define LEAD_ACLK_TICKS     4
+
+// The capture/compare registers of TA0 used here
+#define EDGE_CCR            1
+#define ISR_CCR             2
+#define RESUME_CCR          3
+#define NOW_CCR             4
+
+typedef enum {
+    MODE_ACTIVE,
+    MODE_LPM0,
+    MODE_LPM3,
+    MODE_COUNT
+} Mode;
+
+typedef enum {
+    FLAGS_DRIVERLIB,
+    FLAGS_REGISTERS,
+    FLAGS_COUNT
+} FlagAccess;
+
+static const char *const profileNames[] = { "3MHz", "12MHz", "24MHz", "48MHz" };
+static const char *const modeNames[] = { "active", "LPM0", "LPM3" };
+static const char *const flagNames[] = { "driverlib", "registers" };
+
+static FlagAccess flagAccess;
+
+// Written by the ISR for every edge
+static volatile bool edgeSeen;
+static volatile uint16_t isrTicks;
+static volatile uint32_t flagCycles;
+
+// Cycles taken by two back-to-back reads of CYCCNT
+static uint32_t dwtOverhead;
+
+static uint16_t toIsr[LATENCY_SAMPLES];
+static uint16_t toResume[LATENCY_SAMPLES];
+static uint32_t flagCyclesMin, flagCyclesMax, flagCyclesTotal;
+static uint32_t lpm3Refused;
+
+// Asks for TA0R to be copied into a CCR, by switching its capture input
+// between GND and VCC. The capture is synchronized to the timer clock, so
+// it also works while TA0 runs from ACLK, where reading TA0R does not.
+static inline void startCapture(int ccr)
+{
+    TIMER_A0->CCTL[ccr] ^= TIMER_A_CCTLN_CCIS0;
+}
+
+// Returns the value captured by startCapture()
+static inline uint16_t finishCapture(int ccr)
+{
+    while (!(TIMER_A0->CCTL[ccr] & TIMER_A_CCTLN_CCIFG));
+    TIMER_A0->CCTL[ccr] &= ~TIMER_A_CCTLN_CCIFG;
+    return TIMER_A0->CCR[ccr];
+}
+
+// Replaces the example's handler in this build
+void PORT1_IRQHandler()
+{
+    uint32_t start;
+
+    startCapture(ISR_CCR);
+
+    start = DWT->CYCCNT;
+    if (flagAccess == FLAGS_DRIVERLIB) {
+        if (GPIO_getInterruptStatus(GPIO_PORT_P1, GPIO_PIN7))
+            GPIO_clearInterruptFlag(GPIO_PORT_P1, GPIO_PIN7);
+    } else {
+        if (P1->IFG & BIT7)
+            P1->IFG &= ~BIT7;
+    }
+    flagCycles = DWT->CYCCNT - start - dwtOverhead;
+
+    isrTicks = finishCapture(ISR_CCR);
+    edgeSeen = true;
+}
+
+// Runs TA0 from SMCLK or ACLK, with TA0.1 toggling on compare and the
+// other CCRs set up for software capture
+static void initTimer(bool aclk)
+{
+    int ccr;
+
+    TIMER_A0->CTL = TIMER_A_CTL_CLR;
+    TIMER_A0->CCTL[EDGE_CCR] = TIMER_A_CCTLN_OUTMOD_4;
+    for (ccr = ISR_CCR; ccr <= NOW_CCR; ccr++) {
+        TIMER_A0->CCTL[ccr] = TIMER_A_CCTLN_CAP | TIMER_A_CCTLN_SCS |
+                              TIMER_A_CCTLN_CM__BOTH | TIMER_A_CCTLN_CCIS__GND;
+    }
+    TIMER_A0->CTL = (aclk ? TIMER_A_CTL_TASSEL_1 : TIMER_A_CTL_TASSEL_2) |
+                    TIMER_A_CTL_MC__CONTINUOUS;
+}
+
+// Makes TA0.1 toggle the given number of ticks from now, and sets P1.7 to
+// interrupt on that edge
+static void armEdge(uint16_t lead)
+{
+    if (P1->IN & BIT7)
+        P1->IES |= BIT7;
+    else
+        P1->IES &= ~BIT7;
+
+    // Changing the edge can set the flag
+    P1->IFG &= ~BIT7;
+    edgeSeen = false;
+
+    startCapture(NOW_CCR);
+    TIMER_A0->CCR[EDGE_CCR] = finishCapture(NOW_CCR) + lead;
+}
+
+static void measure(Mode mode)
+{
+    uint16_t lead = (mode == MODE_LPM3) ? LEAD_ACLK_TICKS : LEAD_SMCLK_TICKS;
+    int i;
+
+    initTimer(mode == MODE_LPM3);
+
+    flagCyclesMin = UINT32_MAX;
+    flagCyclesMax = 0;
+    flagCyclesTotal = 0;
+    lpm3Refused = 0;
+
+    for (i = 0; i < LATENCY_SAMPLES; i++) {
+        armEdge(lead);
+
+        if (mode == MODE_LPM0) {
+            PCM_gotoLPM0();
+        } else if (mode == MODE_LPM3) {
+            if (!PCM_gotoLPM3())
+                lpm3Refused++;
+        }
+        while (!edgeSeen);
+
+        startCapture(RESUME_CCR);
+        toResume[i] = finishCapture(RESUME_CCR) - TIMER_A0->CCR[EDGE_CCR];
+        toIsr[i] = isrTicks - TIMER_A0->CCR[EDGE_CCR];
+
+        if (flagCycles < flagCyclesMin)
+            flagCyclesMin = flagCycles;
+        if (flagCycles > flagCyclesMax)
+            flagCyclesMax = flagCycles;
+        flagCyclesTotal += flagCycles;
+    }
+
+    TIMER_A0->CTL = TIMER_A_CTL_MC__STOP;
+}
+
+static void printStats(const char *name, uint32_t min, uint32_t average, uint32_t max)
+{
+    Benchmark_print(name);
+    Benchmark_print(": min ");
+    Benchmark_printNumber(min);
+    Benchmark_print(" avg ");
+    Benchmark_printNumber(average);
+    Benchmark_print(" max ");
+    Benchmark_printNumber(max);
+    Benchmark_print("\n");
+}
+
+static void printHistogram(const char *name, const uint16_t *samples)
+{
+    uint16_t min = UINT16_MAX, max = 0, width;
+    uint32_t total = 0;
+    int i, bin;
+
+    for (i = 0; i < LATENCY_SAMPLES; i++) {
+        if (samples[i] < min)
+            min = samples[i];
+        if (samples[i] > max)
+            max = samples[i];
+        total += samples[i];
+    }
+    printStats(name, min, total / LATENCY_SAMPLES, max);
+
+    width = (max - min) / LATENCY_BINS + 1;
+    for (bin = 0; bin < LATENCY_BINS; bin++) {
+        uint16_t low = min + bin * width;
+        uint32_t count = 0;
+
+        for (i = 0; i < LATENCY_SAMPLES; i++) {
+            if (samples[i] >= low && samples[i] - low < width)
+                count++;
+        }
+        if (count == 0)
+            continue;
+
+        Benchmark_print("    ");
+        Benchmark_printNumber(low);
+        if (width > 1) {
+            Benchmark_print("-");
+            Benchmark_printNumber(low + width - 1);
+        }
+        Benchmark_print(": ");
+        Benchmark_printNumber(count);
+        Benchmark_print("\n");
+    }
+}
+
+static void printResults(ClockProfile profile, Mode mode)
+{
+    Benchmark_print(profileNames[profile]);
+    Benchmark_print(" ");
+    Benchmark_print(modeNames[mode]);
+    Benchmark_print(" ");
+    Benchmark_print(flagNames[flagAccess]);
+    Benchmark_print(", MCLK ");
+    Benchmark_printNumber(CS_getMCLK());
+    Benchmark_print("Hz, ticks of ");
+    Benchmark_printNumber(mode == MODE_LPM3 ? CS_getACLK() : CS_getSMCLK());
+    Benchmark_print("Hz\n");
+
+    if (lpm3Refused != 0) {
+        Benchmark_print("  LPM3 refused ");
+        Benchmark_printNumber(lpm3Refused);
+        Benchmark_print(" times\n");
+    }
+
+    printHistogram("  edge to ISR, ticks", toIsr);
+    printHistogram("  edge to resume, ticks", toResume);
+    printStats("  flag check and clear, MCLK cycles", flagCyclesMin,
+               flagCyclesTotal / LATENCY_SAMPLES, flagCyclesMax);
+}
+
+void Benchmark_latency(void)
+{
+    ClockProfile profile;
+    Mode mode;
+    uint32_t start;
+
+    Benchmark_startCycles();
+    start = DWT->CYCCNT;
+    dwtOverhead = DWT->CYCCNT - start;
+
+    GPIO_setAsPeripheralModuleFunctionOutputPin(GPIO_PORT_P2, GPIO_PIN4,
+                                                GPIO_PRIMARY_MODULE_FUNCTION);
+    GPIO_setAsInputPin(GPIO_PORT_P1, GPIO_PIN7);
+    P1->IE |= BIT7;
+    // Nothing else runs, but the edge must not wait for a section either
+    IrqPriority_enableInterrupt(INT_PORT1, IRQ_LEVEL_UNMASKED);
+    Interrupt_enableMaster();
+
+    for (profile = CLOCK_PROFILE_3MHZ; profile <= CLOCK_PROFILE_48MHZ; profile++) {
+        Benchmark_waitUart();
+        ClockProfile_set(profile);
+        Benchmark_initUart();
+
+        for (mode = MODE_ACTIVE; mode < MODE_COUNT; mode++) {
+            for (flagAccess = FLAGS_DRIVERLIB; flagAccess < FLAGS_COUNT; flagAccess++) {
+                // SMCLK stops in LPM3, so the UART must be done by then
+                Benchmark_waitUart();
+                measure(mode);
+                printResults(profile, mode);
+            }
+        }
+    }
+
+    Benchmark_print("done\n");
+    Benchmark_waitUart();
+}
+
+#endif
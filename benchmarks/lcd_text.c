@@ -0,0 +1,102 @@
+// Text drawing benchmark (BENCHMARK_LCD_TEXT)
+//
+// Fills the screen with lines of 6x8 text, over and over, in three ways:
+// grlib with an opaque background (the 1bpp PixelDrawMultiple path), grlib
+// with a transparent background (grlib's own per-pixel path), and the driver's
+// Crystalfontz128x128_DrawMonoBitmap() with a transparent background.
+// Build once with LCD_MONO_RUN_LENGTH=0 and once without to compare the
+// per-pixel and run-length drivers.
+
+#include <ti/devices/msp432p4xx/driverlib/driverlib.h>
+#include <ti/grlib/grlib.h>
+#include "LcdDriver/Crystalfontz128x128_ST7735.h"
+#include "benchmarks/benchmark.h"
+#include <string.h>
+
+#if BENCHMARK == BENCHMARK_LCD_TEXT
+
+// Number of times the screen is filled with text for each case
+#define TEXT_PASSES     8
+
+#define TEXT_LINES      16
+#define GLYPH_WIDTH     6
+#define GLYPH_HEIGHT    8
+
+// Results, in glyphs per second
+volatile uint32_t LcdText_opaqueGlyphsPerSecond;
+volatile uint32_t LcdText_transparentGlyphsPerSecond;
+volatile uint32_t LcdText_monoBitmapGlyphsPerSecond;
+
+static const char text[] = "The quick brown fox ";
+
+// An 'A' in the same cell size as the grlib fixed font, one byte per row
+static const uint8_t glyph[GLYPH_HEIGHT] = {
+    0x20, 0x50, 0x88, 0x88, 0xF8, 0x88, 0x88, 0x00
+};
+
+static uint32_t drawWithGrlib(Graphics_Context *context, bool opaque)
+{
+    unsigned pass, line;
+
+    Benchmark_startCycles();
+    for (pass = 0; pass < TEXT_PASSES; pass++) {
+        for (line = 0; line < TEXT_LINES; line++) {
+            Graphics_drawString(context, (int8_t *) text, -1, 0,
+                                line * GLYPH_HEIGHT, opaque);
+        }
+        Graphics_flushBuffer(context);
+    }
+    return Benchmark_cycles();
+}
+
+static uint32_t drawWithMonoBitmap(Graphics_Context *context, uint16_t color)
+{
+    unsigned pass, line, column;
+    unsigned columns = strlen(text);
+
+    Benchmark_startCycles();
+    for (pass = 0; pass < TEXT_PASSES; pass++) {
+        for (line = 0; line < TEXT_LINES; line++) {
+            for (column = 0; column < columns; column++) {
+                Crystalfontz128x128_DrawMonoBitmap(column * GLYPH_WIDTH,
+                                                   line * GLYPH_HEIGHT,
+                                                   GLYPH_WIDTH, GLYPH_HEIGHT,
+                                                   glyph, color, 0, false);
+            }
+        }
+        Graphics_flushBuffer(context);
+    }
+    return Benchmark_cycles();
+}
+
+void Benchmark_lcdText(void)
+{
+    Graphics_Context context;
+    uint32_t glyphs = strlen(text) * TEXT_LINES * TEXT_PASSES;
+    uint32_t color;
+
+    Crystalfontz128x128_Init();
+    Crystalfontz128x128_SetOrientation(LCD_ORIENTATION_UP);
+
+    Graphics_initContext(&context, &g_sCrystalfontz128x128,
+                         &g_sCrystalfontz128x128_funcs);
+    Graphics_setForegroundColor(&context, GRAPHICS_COLOR_YELLOW);
+    Graphics_setBackgroundColor(&context, GRAPHICS_COLOR_NAVY);
+    Graphics_setFont(&context, &g_sFontFixed6x8);
+    Graphics_clearDisplay(&context);
+
+    LcdText_opaqueGlyphsPerSecond =
+            Benchmark_perSecond(glyphs, drawWithGrlib(&context, true));
+
+    Graphics_clearDisplay(&context);
+    LcdText_transparentGlyphsPerSecond =
+            Benchmark_perSecond(glyphs, drawWithGrlib(&context, false));
+
+    Graphics_clearDisplay(&context);
+    color = Graphics_translateColorOnDisplay(&g_sCrystalfontz128x128,
+                                             GRAPHICS_COLOR_YELLOW);
+    LcdText_monoBitmapGlyphsPerSecond =
+            Benchmark_perSecond(glyphs, drawWithMonoBitmap(&context, color));
+}
+
+#endif
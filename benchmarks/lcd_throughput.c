@@ -0,0 +1,259 @@
+// LCD driver throughput benchmark (BENCHMARK_LCD_THROUGHPUT)
+//
+// Times every entry of g_sCrystalfontz128x128_funcs that draws, and a screen
+// of grlib text, with the DWT. Each test runs for every clock profile and
+// every transfer mode the HAL accepts; build with LCD_TRANSFER_SELECT=1 to
+// get PIO and burst next to DMA, and again with LCD_COLOR_DEPTH=12 for the
+// 12-bit mode. Every result is one line of comma separated values on the
+// UART, after a header naming the columns:
+//
+//   profile, mode, bpp, test, pixels, bytes, cycles, pixels/s, bytes/s,
+//   efficiency, spi_hz
+//
+// bytes is what went over the SPI, commands included, and efficiency is
+// bytes/s * 8 against LCD_SPI_CLOCK_SPEED, in tenths of a percent. spi_hz
+// is the SPI clock actually used, which is lower when SMCLK does not divide
+// down to LCD_SPI_CLOCK_SPEED.
+
+#include <ti/devices/msp432p4xx/driverlib/driverlib.h>
+#include <ti/grlib/grlib.h>
+#include "LcdDriver/Crystalfontz128x128_ST7735.h"
+#include "LcdDriver/HAL_MSP_EXP432P401R_Crystalfontz128x128_ST7735.h"
+#include "benchmarks/benchmark.h"
+#include "clock_profile.h"
+
+#if BENCHMARK == BENCHMARK_LCD_THROUGHPUT
+
+// Times each test is repeated for one result
+#define THROUGHPUT_PASSES   4
+
+#define SCREEN_SIZE         128
+#define TEXT_LINES          16
+#define GLYPH_HEIGHT        8
+
+typedef enum {
+    TEST_PIXEL,
+    TEST_MULTIPLE_1BPP,
+    TEST_MULTIPLE_4BPP,
+    TEST_MULTIPLE_8BPP,
+    TEST_MULTIPLE_16BPP,
+    TEST_LINE_H,
+    TEST_LINE_V,
+    TEST_RECT,
+    TEST_CLEAR,
+    TEST_TEXT,
+    TEST_COUNT
+} Test;
+
+static const char *const profileNames[] = { "3MHz", "12MHz", "24MHz", "48MHz" };
+static const char *const modeNames[] = { "pio", "burst", "dma" };
+static const char *const testNames[] = {
+    "pixel", "multiple_1bpp", "multiple_4bpp", "multiple_8bpp",
+    "multiple_16bpp", "line_h", "line_v", "rect", "clear", "text"
+};
+
+static const char text[] = "The quick brown fox ";
+
+// One screen row of source data for each PixelDrawMultiple format, and the
+// palettes, already translated as grlib passes them
+static uint8_t row1bpp[SCREEN_SIZE / 8];
+static uint8_t row4bpp[SCREEN_SIZE / 2];
+static uint8_t row8bpp[SCREEN_SIZE];
+static uint16_t row16bpp[SCREEN_SIZE];
+static uint32_t palette[256];
+
+static const Graphics_Display_Functions *const funcs = &g_sCrystalfontz128x128_funcs;
+static const Graphics_Display *const display = &g_sCrystalfontz128x128;
+
+static void initData(void)
+{
+    int i;
+
+    for (i = 0; i < 256; i++) {
+        palette[i] = funcs->pfnColorTranslate(display,
+                ((uint32_t)i << 16) | ((uint32_t)(255 - i) << 8) | (i ^ 0x55));
+    }
+    for (i = 0; i < SCREEN_SIZE / 8; i++)
+        row1bpp[i] = 0xF0 ^ (i << 1);
+    for (i = 0; i < SCREEN_SIZE / 2; i++)
+        row4bpp[i] = (i & 0xF) | ((~i & 0xF) << 4);
+    for (i = 0; i < SCREEN_SIZE; i++) {
+        row8bpp[i] = i * 7;
+        row16bpp[i] = palette[i];
+    }
+}
+
+// Draws one pass of a test, and returns the number of pixels it drew
+static uint32_t drawPass(Graphics_Context *context, Test test)
+{
+    Graphics_Rectangle rect;
+    int16_t x, y;
+    uint16_t color = palette[0x80];
+
+    switch (test) {
+    case TEST_PIXEL:
+        // Row by row, as grlib draws a filled shape pixel by pixel
+        for (y = 0; y < SCREEN_SIZE; y++) {
+            for (x = 0; x < SCREEN_SIZE; x++)
+                funcs->pfnPixelDraw(display, x, y, palette[x ^ y]);
+        }
+        return SCREEN_SIZE * SCREEN_SIZE;
+
+    case TEST_MULTIPLE_1BPP:
+        for (y = 0; y < SCREEN_SIZE; y++)
+            funcs->pfnPixelDrawMultiple(display, 0, y, 0, SCREEN_SIZE, 1, row1bpp, palette);
+        return SCREEN_SIZE * SCREEN_SIZE;
+
+    case TEST_MULTIPLE_4BPP:
+        for (y = 0; y < SCREEN_SIZE; y++)
+            funcs->pfnPixelDrawMultiple(display, 0, y, 0, SCREEN_SIZE, 4, row4bpp, palette);
+        return SCREEN_SIZE * SCREEN_SIZE;
+
+    case TEST_MULTIPLE_8BPP:
+        for (y = 0; y < SCREEN_SIZE; y++)
+            funcs->pfnPixelDrawMultiple(display, 0, y, 0, SCREEN_SIZE, 8, row8bpp, palette);
+        return SCREEN_SIZE * SCREEN_SIZE;
+
+    case TEST_MULTIPLE_16BPP:
+        for (y = 0; y < SCREEN_SIZE; y++) {
+            funcs->pfnPixelDrawMultiple(display, 0, y, 0, SCREEN_SIZE, 16,
+                                        (const uint8_t *)row16bpp, palette);
+        }
+        return SCREEN_SIZE * SCREEN_SIZE;
+
+    case TEST_LINE_H:
+        for (y = 0; y < SCREEN_SIZE; y++)
+            funcs->pfnLineDrawH(display, 0, SCREEN_SIZE - 1, y, palette[y]);
+        return SCREEN_SIZE * SCREEN_SIZE;
+
+    case TEST_LINE_V:
+        for (x = 0; x < SCREEN_SIZE; x++)
+            funcs->pfnLineDrawV(display, x, 0, SCREEN_SIZE - 1, palette[x]);
+        return SCREEN_SIZE * SCREEN_SIZE;
+
+    case TEST_RECT:
+        // A grid of 16x16 rectangles
+        for (y = 0; y < SCREEN_SIZE; y += 16) {
+            for (x = 0; x < SCREEN_SIZE; x += 16) {
+                rect.sXMin = x;
+                rect.sYMin = y;
+                rect.sXMax = x + 15;
+                rect.sYMax = y + 15;
+                funcs->pfnRectFill(display, &rect, palette[x + y]);
+            }
+        }
+        return SCREEN_SIZE * SCREEN_SIZE;
+
+    case TEST_CLEAR:
+        funcs->pfnClearDisplay(display, color);
+        return SCREEN_SIZE * SCREEN_SIZE;
+
+    case TEST_TEXT:
+        for (y = 0; y < TEXT_LINES; y++) {
+            Graphics_drawString(context, (int8_t *) text, -1, 0,
+                                y * GLYPH_HEIGHT, true);
+        }
+        return Graphics_getStringWidth(context, (int8_t *) text, -1) *
+               GLYPH_HEIGHT * TEXT_LINES;
+
+    default:
+        return 0;
+    }
+}
+
+static void printResult(ClockProfile profile, HAL_LCD_TransferMode mode, Test test,
+                        uint32_t pixels, uint32_t bytes, uint32_t cycles)
+{
+    uint32_t bytesPerSecond = Benchmark_perSecond(bytes, cycles);
+
+    Benchmark_print(profileNames[profile]);
+    Benchmark_print(",");
+    Benchmark_print(modeNames[mode]);
+    Benchmark_print(",");
+    Benchmark_printNumber(LCD_COLOR_DEPTH);
+    Benchmark_print(",");
+    Benchmark_print(testNames[test]);
+    Benchmark_print(",");
+    Benchmark_printNumber(pixels);
+    Benchmark_print(",");
+    Benchmark_printNumber(bytes);
+    Benchmark_print(",");
+    Benchmark_printNumber(cycles);
+    Benchmark_print(",");
+    Benchmark_printNumber(Benchmark_perSecond(pixels, cycles));
+    Benchmark_print(",");
+    Benchmark_printNumber(bytesPerSecond);
+    Benchmark_print(",");
+    Benchmark_printNumber((uint32_t)((uint64_t)bytesPerSecond * 8 * 1000 / LCD_SPI_CLOCK_SPEED));
+    Benchmark_print(",");
+    Benchmark_printNumber(HAL_LCD_getSpiClock());
+    Benchmark_print("\n");
+}
+
+static void runTest(Graphics_Context *context, ClockProfile profile,
+                    HAL_LCD_TransferMode mode, Test test)
+{
+    uint32_t pixels = 0, bytes, cycles;
+    int pass;
+
+    // Nothing from the previous test may still be on the wire
+    funcs->pfnFlush(display);
+
+    bytes = HAL_LCD_getBytesSent();
+    Benchmark_startCycles();
+    for (pass = 0; pass < THROUGHPUT_PASSES; pass++)
+        pixels += drawPass(context, test);
+    funcs->pfnFlush(display);
+    cycles = Benchmark_cycles();
+    bytes = HAL_LCD_getBytesSent() - bytes;
+
+    printResult(profile, mode, test, pixels, bytes, cycles);
+}
+
+void Benchmark_lcdThroughput(void)
+{
+    Graphics_Context context;
+    ClockProfile profile;
+    HAL_LCD_TransferMode mode;
+    Test test;
+
+    Crystalfontz128x128_Init();
+    Crystalfontz128x128_SetOrientation(LCD_ORIENTATION_UP);
+
+    Graphics_initContext(&context, &g_sCrystalfontz128x128,
+                         &g_sCrystalfontz128x128_funcs);
+    Graphics_setForegroundColor(&context, GRAPHICS_COLOR_YELLOW);
+    Graphics_setBackgroundColor(&context, GRAPHICS_COLOR_NAVY);
+    Graphics_setFont(&context, &g_sFontFixed6x8);
+
+    initData();
+
+    Benchmark_initUart();
+    Benchmark_print("profile,mode,bpp,test,pixels,bytes,cycles,pixels_per_s,"
+                    "bytes_per_s,efficiency_permille,spi_hz\n");
+
+    for (profile = CLOCK_PROFILE_3MHZ; profile <= CLOCK_PROFILE_48MHZ; profile++) {
+        Benchmark_waitUart();
+        ClockProfile_set(profile);
+        Benchmark_initUart();
+
+        for (mode = HAL_LCD_TRANSFER_PIO; mode <= HAL_LCD_TRANSFER_DMA; mode++) {
+            if (!HAL_LCD_setTransferMode(mode))
+                continue;
+
+            for (test = TEST_PIXEL; test < TEST_COUNT; test++) {
+                // The previous result is sent before the next test starts
+                Benchmark_waitUart();
+                runTest(&context, profile, mode, test);
+            }
+        }
+    }
+
+    // Leave the driver as it was built
+    HAL_LCD_setTransferMode(LCD_USE_DMA ? HAL_LCD_TRANSFER_DMA : HAL_LCD_TRANSFER_BURST);
+
+    Benchmark_print("done\n");
+    Benchmark_waitUart();
+}
+
+#endif
@@ -0,0 +1,132 @@
+#include <ti/devices/msp432p4xx/driverlib/driverlib.h>
+#include "buttons.h"
+#include "gpio_irq.h"
+#include "sw_timer.h"
+
+typedef struct {
+    uint_fast16_t pin;
+
+    // Debounced state
+    volatile bool pressed;
+
+    SwTimer sampleTimer;
+    SwTimer longPressTimer;
+
+    // Runs from a release until a press would no longer be a double tap
+    SwTimer tapTimer;
+} ButtonState;
+
+// Both buttons are on port 1, active low with pull-ups
+static ButtonState buttons[BUTTON_COUNT] = {
+    { .pin = GPIO_PIN1 },
+    { .pin = GPIO_PIN4 }
+};
+
+static EventQueue *events;
+
+static void report(Button button, EventType s1Event)
+{
+    EventQueue_push(events, (EventType) (s1Event + button * BUTTON_EVENT_COUNT));
+}
+
+static bool pinIsLow(const ButtonState *state)
+{
+    return GPIO_getInputPinValue(GPIO_PORT_P1, state->pin) == GPIO_INPUT_PIN_LOW;
+}
+
+static void sample(void *arg);
+static void edge(void *arg);
+
+// Waits for the edge that would change the debounced state
+static void armEdge(Button button)
+{
+    ButtonState *state = &buttons[button];
+
+    // Changing the edge can set the flag, so clear it afterwards
+    GPIO_interruptEdgeSelect(GPIO_PORT_P1, state->pin,
+                             state->pressed ? GPIO_LOW_TO_HIGH_TRANSITION : GPIO_HIGH_TO_LOW_TRANSITION);
+    GPIO_clearInterruptFlag(GPIO_PORT_P1, state->pin);
+    GPIO_enableInterrupt(GPIO_PORT_P1, state->pin);
+
+    // The pin may have changed before the interrupt was armed
+    if (pinIsLow(state) != state->pressed) {
+        GPIO_disableInterrupt(GPIO_PORT_P1, state->pin);
+        SwTimer_start(&state->sampleTimer, BUTTONS_DEBOUNCE_US, 0, sample, (void *) (uintptr_t) button);
+    }
+}
+
+static void longPress(void *arg)
+{
+    Button button = (Button) (uintptr_t) arg;
+
+    if (buttons[button].pressed)
+        report(button, EVENT_S1_LONG_PRESS);
+}
+
+// Nothing to do: only whether the tap timer is still running matters
+static void tapWindowOver(void *arg)
+{
+}
+
+// Runs once the contacts have settled after an edge
+static void sample(void *arg)
+{
+    Button button = (Button) (uintptr_t) arg;
+    ButtonState *state = &buttons[button];
+    bool pressed = pinIsLow(state);
+
+    // Otherwise it was only a bounce or a glitch
+    if (pressed != state->pressed) {
+        state->pressed = pressed;
+
+        if (pressed) {
+            report(button, EVENT_S1_PRESSED);
+            if (SwTimer_isActive(&state->tapTimer)) {
+                SwTimer_cancel(&state->tapTimer);
+                report(button, EVENT_S1_DOUBLE_TAP);
+            }
+            SwTimer_start(&state->longPressTimer, BUTTONS_LONG_PRESS_US, 0, longPress, arg);
+        }
+        else {
+            report(button, EVENT_S1_RELEASED);
+            SwTimer_cancel(&state->longPressTimer);
+            SwTimer_start(&state->tapTimer, BUTTONS_DOUBLE_TAP_US, 0, tapWindowOver, arg);
+        }
+    }
+
+    armEdge(button);
+}
+
+// Runs in the port 1 ISR for an edge of a button, whose flag it already
+// cleared
+static void edge(void *arg)
+{
+    ButtonState *state = &buttons[(uintptr_t) arg];
+
+    // Ignore the pin until the contacts have settled
+    GPIO_disableInterrupt(GPIO_PORT_P1, state->pin);
+    SwTimer_start(&state->sampleTimer, BUTTONS_DEBOUNCE_US, 0, sample, arg);
+}
+
+void Buttons_init(EventQueue *queue)
+{
+    unsigned button;
+
+    events = queue;
+
+    for (button = 0; button < BUTTON_COUNT; button++) {
+        ButtonState *state = &buttons[button];
+
+        GPIO_setAsInputPinWithPullUpResistor(GPIO_PORT_P1, state->pin);
+        state->pressed = pinIsLow(state);
+
+        // Also enables the port 1 interrupt
+        GpioIrq_register(GPIO_PORT_P1, state->pin, edge, (void *) (uintptr_t) button);
+        armEdge((Button) button);
+    }
+}
+
+bool Buttons_isPressed(Button button)
+{
+    return buttons[button].pressed;
+}
@@ -0,0 +1,46 @@
+// Debounced buttons with press, release, long press and double tap events
+//
+// S1 (P1.1) and S2 (P1.4) each cost one interrupt per edge and nothing in
+// between. The first edge masks the pin's interrupt, and a software timer
+// samples the pin once the contacts have settled. If the new state holds, it
+// is reported, and the pin is armed for the opposite edge. Bounces in
+// between are never seen.
+//
+// A press is reported as soon as it is confirmed. A second press within
+// BUTTONS_DOUBLE_TAP_US of the previous release is also reported as a double
+// tap, and a press held for BUTTONS_LONG_PRESS_US as a long press.
+
+#ifndef BUTTONS_H_
+#define BUTTONS_H_
+
+#include <stdbool.h>
+#include "event_queue.h"
+
+// Time for the contacts to settle after an edge
+#ifndef BUTTONS_DEBOUNCE_US
+#define BUTTONS_DEBOUNCE_US 10000
+#endif
+
+#ifndef BUTTONS_LONG_PRESS_US
+#define BUTTONS_LONG_PRESS_US 800000
+#endif
+
+#ifndef BUTTONS_DOUBLE_TAP_US
+#define BUTTONS_DOUBLE_TAP_US 300000
+#endif
+
+typedef enum {
+    BUTTON_S1,
+    BUTTON_S2,
+    BUTTON_COUNT
+} Button;
+
+// Configures the pins and registers their interrupts with gpio_irq. Events
+// go to the given queue, all pushed from the software timer ISR, which is
+// the queue's only producer. SwTimer_init() must have been called.
+void Buttons_init(EventQueue *queue);
+
+// Returns the debounced state of a button
+bool Buttons_isPressed(Button button);
+
+#endif /* BUTTONS_H_ */
@@ -0,0 +1,78 @@
+#include <ti/devices/msp432p4xx/driverlib/driverlib.h>
+#include "clock_profile.h"
+
+typedef struct {
+    uint32_t dcoFrequency;
+    uint_fast8_t coreVoltage;
+    uint32_t flashWaitStates;
+    uint32_t smclkDivider;
+} ClockSettings;
+
+// Indexed by ClockProfile. The voltage and wait states are the smallest that
+// the datasheet allows at each frequency, as in system_msp432p401r.c.
+static const ClockSettings settings[] = {
+    { CS_DCO_FREQUENCY_3,  PCM_VCORE0, 0, CS_CLOCK_DIVIDER_1 },
+    { CS_DCO_FREQUENCY_12, PCM_VCORE0, 0, CS_CLOCK_DIVIDER_1 },
+    { CS_DCO_FREQUENCY_24, PCM_VCORE0, 1, CS_CLOCK_DIVIDER_1 },
+    { CS_DCO_FREQUENCY_48, PCM_VCORE1, 1, CS_CLOCK_DIVIDER_2 }
+};
+
+static ClockProfile currentProfile = CLOCK_PROFILE_3MHZ;
+
+static ClockProfile_Subscriber subscribers[CLOCK_PROFILE_MAX_SUBSCRIBERS];
+static unsigned subscriberCount = 0;
+
+static void setFlashWaitStates(uint32_t waitStates)
+{
+    FlashCtl_setWaitState(FLASH_BANK0, waitStates);
+    FlashCtl_setWaitState(FLASH_BANK1, waitStates);
+}
+
+void ClockProfile_set(ClockProfile profile)
+{
+    const ClockSettings *from = &settings[currentProfile];
+    const ClockSettings *to = &settings[profile];
+    unsigned i;
+
+    if (profile == currentProfile)
+        return;
+
+    if (profile > currentProfile) {
+        // Going faster: the core voltage and wait states have to be ready
+        // before the clock gets there, and SMCLK must be divided before the
+        // DCO doubles it
+        if (to->coreVoltage != from->coreVoltage)
+            PCM_setCoreVoltageLevel(to->coreVoltage);
+        setFlashWaitStates(to->flashWaitStates);
+        CS_initClockSignal(CS_SMCLK, CS_DCOCLK_SELECT, to->smclkDivider);
+        CS_setDCOCenteredFrequency(to->dcoFrequency);
+    }
+    else {
+        // Going slower: the other way around
+        CS_setDCOCenteredFrequency(to->dcoFrequency);
+        CS_initClockSignal(CS_SMCLK, CS_DCOCLK_SELECT, to->smclkDivider);
+        setFlashWaitStates(to->flashWaitStates);
+        if (to->coreVoltage != from->coreVoltage)
+            PCM_setCoreVoltageLevel(to->coreVoltage);
+    }
+
+    currentProfile = profile;
+    SystemCoreClock = CS_getMCLK();
+
+    for (i = 0; i < subscriberCount; i++)
+        subscribers[i]();
+}
+
+ClockProfile ClockProfile_get()
+{
+    return currentProfile;
+}
+
+bool ClockProfile_subscribe(ClockProfile_Subscriber subscriber)
+{
+    if (subscriberCount == CLOCK_PROFILE_MAX_SUBSCRIBERS)
+        return false;
+
+    subscribers[subscriberCount++] = subscriber;
+    return true;
+}
@@ -0,0 +1,42 @@
+// Switches the core clock between a few fixed frequencies at runtime
+//
+// Each profile runs MCLK and HSMCLK from the DCO at the given frequency and
+// SMCLK at the same frequency, halved at 48MHz to stay within its 24MHz
+// limit. The core voltage and flash wait states follow the same table as
+// system_msp432p401r.c. The device boots in CLOCK_PROFILE_3MHZ.
+//
+// Modules whose timing depends on the clock subscribe to be told after every
+// change; by then SystemCoreClock holds the new MCLK frequency.
+
+#ifndef CLOCK_PROFILE_H_
+#define CLOCK_PROFILE_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Maximum number of subscribers
+#ifndef CLOCK_PROFILE_MAX_SUBSCRIBERS
+#define CLOCK_PROFILE_MAX_SUBSCRIBERS 4
+#endif
+
+typedef enum {
+    CLOCK_PROFILE_3MHZ,
+    CLOCK_PROFILE_12MHZ,
+    CLOCK_PROFILE_24MHZ,
+    CLOCK_PROFILE_48MHZ
+} ClockProfile;
+
+typedef void (*ClockProfile_Subscriber)();
+
+// Switches to the given profile and then calls every subscriber. Only call
+// from main, not from ISRs.
+void ClockProfile_set(ClockProfile profile);
+
+// Returns the current profile
+ClockProfile ClockProfile_get();
+
+// Adds a function to call after every clock change. Returns false if there
+// are already CLOCK_PROFILE_MAX_SUBSCRIBERS.
+bool ClockProfile_subscribe(ClockProfile_Subscriber subscriber);
+
+#endif /* CLOCK_PROFILE_H_ */
@@ -0,0 +1,27 @@
+#include <ti/devices/msp432p4xx/driverlib/driverlib.h>
+#include "dma_table.h"
+
+// The controller requires the table to be aligned on a 1024 byte boundary;
+// 16 entries cover the primary and alternate structures of the 8 channels
+#if defined(__TI_COMPILER_VERSION__)
+#pragma DATA_ALIGN(controlTable, 1024)
+#elif defined(__IAR_SYSTEMS_ICC__)
+#pragma data_alignment=1024
+#elif defined(__GNUC__)
+__attribute__ ((aligned (1024)))
+#elif defined(__CC_ARM)
+__align(1024)
+#endif
+static DMA_ControlTable controlTable[16];
+
+static bool initialized = false;
+
+void DmaTable_init()
+{
+    if (initialized)
+        return;
+
+    DMA_enableModule();
+    DMA_setControlBase(controlTable);
+    initialized = true;
+}
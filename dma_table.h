@@ -0,0 +1,15 @@
+// The uDMA control table, shared by every module that uses a DMA channel
+//
+// The controller has a single table for all 8 channels, so it is set up
+// once, here, and each module only configures its own channels. A channel
+// belongs to one module: the LCD HAL uses channel 0 (EUSCI_B0 TX) and the
+// ADC stream channel 7 (ADC14).
+
+#ifndef DMA_TABLE_H_
+#define DMA_TABLE_H_
+
+// Enables the uDMA controller and points it at the table. Call before
+// configuring a channel; later calls do nothing.
+void DmaTable_init();
+
+#endif /* DMA_TABLE_H_ */
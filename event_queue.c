@@ -0,0 +1,60 @@
+#include <ti/devices/msp432p4xx/driverlib/driverlib.h>
+#include "event_queue.h"
+#include "sleep_manager.h"
+#include "timestamp.h"
+
+#define EVENT_QUEUE_MASK (EVENT_QUEUE_SIZE - 1)
+
+bool EventQueue_push(EventQueue *queue, EventType type)
+{
+    uint16_t head = queue->head;
+
+    if ((uint16_t) (head - queue->tail) == EVENT_QUEUE_SIZE) {
+        queue->overflows++;
+        return false;
+    }
+
+    queue->events[head & EVENT_QUEUE_MASK].timestamp = Timestamp_now();
+    queue->events[head & EVENT_QUEUE_MASK].type = type;
+
+    // Publish the event only once it is complete. Both are volatile, so
+    // the compiler keeps the stores in this order, and the core does not
+    // reorder them.
+    queue->head = head + 1;
+
+#if SLEEP_ON_EXIT
+    // The scheduler runs from PendSV
+    SCB->ICSR = SCB_ICSR_PENDSVSET_Msk;
+#endif
+
+    if ((uint16_t) (head + 1 - queue->tail) > queue->highWater)
+        queue->highWater = head + 1 - queue->tail;
+    return true;
+}
+
+bool EventQueue_isEmpty(const EventQueue *queue)
+{
+    return queue->head == queue->tail;
+}
+
+bool EventQueue_peek(const EventQueue *queue, Event *event)
+{
+    uint16_t tail = queue->tail;
+
+    if (queue->head == tail)
+        return false;
+
+    event->timestamp = queue->events[tail & EVENT_QUEUE_MASK].timestamp;
+    event->type = queue->events[tail & EVENT_QUEUE_MASK].type;
+    return true;
+}
+
+bool EventQueue_pop(EventQueue *queue, Event *event)
+{
+    if (!EventQueue_peek(queue, event))
+        return false;
+
+    // Hand the slot back to the producer only after it has been copied
+    queue->tail++;
+    return true;
+}
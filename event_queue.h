@@ -0,0 +1,80 @@
+// Fixed-size, timestamped event queues from ISRs to main
+//
+// Each queue has exactly one producer (an ISR) and one consumer (main, or
+// the scheduler's PendSV handler with SLEEP_ON_EXIT=1), so
+// neither side ever has to disable interrupts: the producer is the only one
+// that writes head and overflows, and the consumer the only one that writes
+// tail. An event that finds its queue full is dropped and counted instead
+// of overwriting one that main has not seen yet.
+
+#ifndef EVENT_QUEUE_H_
+#define EVENT_QUEUE_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Number of events each queue holds. Must be a power of two.
+#ifndef EVENT_QUEUE_SIZE
+#define EVENT_QUEUE_SIZE 8
+#endif
+
+#if (EVENT_QUEUE_SIZE & (EVENT_QUEUE_SIZE - 1)) != 0
+#error "EVENT_QUEUE_SIZE must be a power of two"
+#endif
+
+// The button events of S2 are in the same order as those of S1, so that
+// EVENT_S1_PRESSED + n * BUTTON_EVENT_COUNT is the first event of button n
+typedef enum {
+    EVENT_S1_PRESSED,
+    EVENT_S1_RELEASED,
+    EVENT_S1_LONG_PRESS,
+    EVENT_S1_DOUBLE_TAP,
+    EVENT_S2_PRESSED,
+    EVENT_S2_RELEASED,
+    EVENT_S2_LONG_PRESS,
+    EVENT_S2_DOUBLE_TAP,
+    EVENT_TIMER_EXPIRED,
+    // AdcStream_readyBlock() has a new block
+    EVENT_ADC_BLOCK_READY
+} EventType;
+
+#define BUTTON_EVENT_COUNT (EVENT_S2_PRESSED - EVENT_S1_PRESSED)
+
+typedef struct {
+    // Timestamp_now() when the event was pushed
+    uint32_t timestamp;
+    EventType type;
+} Event;
+
+typedef struct {
+    volatile Event events[EVENT_QUEUE_SIZE];
+
+    // Free-running counts of pushed and popped events; head - tail is the
+    // number of events in the queue
+    volatile uint16_t head;
+    volatile uint16_t tail;
+
+    // Number of events dropped because the queue was full
+    volatile uint32_t overflows;
+
+    // The most events the queue has held at once; when it reaches
+    // EVENT_QUEUE_SIZE the queue is too small
+    volatile uint16_t highWater;
+} EventQueue;
+
+// Adds an event stamped with the current time. Only call from the queue's
+// producer. Returns false, and counts an overflow, if the queue is full.
+bool EventQueue_push(EventQueue *queue, EventType type);
+
+// Copies the oldest event into *event without removing it. Only call from
+// the consumer. Returns false if the queue is empty.
+bool EventQueue_peek(const EventQueue *queue, Event *event);
+
+// Returns true if the queue has no events. Safe to call from either side.
+bool EventQueue_isEmpty(const EventQueue *queue);
+
+// Removes the oldest event and copies it into *event. Only call from the
+// consumer. Returns false if the queue is empty.
+bool EventQueue_pop(EventQueue *queue, Event *event);
+
+#endif /* EVENT_QUEUE_H_ */
@@ -0,0 +1,93 @@
+#include <ti/devices/msp432p4xx/driverlib/driverlib.h>
+#include "benchmarks/benchmark.h"
+#include "gpio_irq.h"
+#include "irq_priority.h"
+#include "profiler.h"
+#include "ramfunc.h"
+
+#define PORT_COUNT      6
+#define PINS_PER_PORT   8
+
+typedef struct {
+    GpioIrq_Handler handler;
+    void *arg;
+} PinEntry;
+
+// Indexed by port - 1 and pin number
+static PinEntry pinTable[PORT_COUNT][PINS_PER_PORT];
+
+// Calls the handlers of every pending pin of a port. iv is the port's PxIV:
+// it reads 0 when no pin is pending, or 2 * (pin + 1) for the pending pin
+// with the lowest number, whose flag the read clears.
+static inline void dispatch(const PinEntry *entries, const volatile uint16_t *iv)
+{
+    uint_fast16_t vector;
+
+    while ((vector = *iv) != 0) {
+        const PinEntry *entry = &entries[(vector >> 1) - 1];
+
+        // A pin nobody registered is only cleared
+        if (entry->handler)
+            entry->handler(entry->arg);
+    }
+}
+
+#if BENCHMARK != BENCHMARK_LATENCY
+// RAMFUNC runs the dispatchers from SRAM, without flash wait states
+RAMFUNC void PORT1_IRQHandler()
+{
+    PROFILE_BEGIN(PROFILE_PORT1_ISR);
+
+    dispatch(pinTable[0], &P1->IV);
+
+    PROFILE_END(PROFILE_PORT1_ISR);
+}
+#endif
+
+RAMFUNC void PORT2_IRQHandler()
+{
+    dispatch(pinTable[1], &P2->IV);
+}
+
+RAMFUNC void PORT3_IRQHandler()
+{
+    dispatch(pinTable[2], &P3->IV);
+}
+
+RAMFUNC void PORT4_IRQHandler()
+{
+    dispatch(pinTable[3], &P4->IV);
+}
+
+RAMFUNC void PORT5_IRQHandler()
+{
+    dispatch(pinTable[4], &P5->IV);
+}
+
+RAMFUNC void PORT6_IRQHandler()
+{
+    dispatch(pinTable[5], &P6->IV);
+}
+
+void GpioIrq_register(uint_fast8_t port, uint_fast16_t pins,
+                      GpioIrq_Handler handler, void *arg)
+{
+    PinEntry *entries = pinTable[port - GPIO_PORT_P1];
+    unsigned pin;
+    uint8_t previousMask;
+
+    // The port's ISR must never see a handler with the previous pin's arg
+    previousMask = IrqPriority_enter(IRQ_LEVEL_GPIO);
+
+    for (pin = 0; pin < PINS_PER_PORT; pin++) {
+        if (pins & (1 << pin)) {
+            entries[pin].handler = handler;
+            entries[pin].arg = arg;
+        }
+    }
+
+    IrqPriority_exit(previousMask);
+
+    // The port interrupts are numbered in order
+    IrqPriority_enableInterrupt(INT_PORT1 + (port - GPIO_PORT_P1), IRQ_LEVEL_GPIO);
+}
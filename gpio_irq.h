@@ -0,0 +1,34 @@
+// Pin interrupt dispatch for ports 1 to 6
+//
+// This module defines PORT1_IRQHandler to PORT6_IRQHandler. Each of them
+// reads its port's PxIV register, which returns the pending pin with the
+// highest priority (the lowest pin number) and clears its flag in the same
+// read. It then calls the handler registered for that pin through a table,
+// and reads again until no pin is left. A pin is found and cleared in one
+// read, however many pins the port has in use, and the interrupt is entered
+// only once for pins that go off together.
+//
+// Handlers run in the port's ISR with the flag already cleared. Keep them
+// short, e.g. start a software timer or push an event for main.
+//
+// The latency benchmark (BENCHMARK_LATENCY) defines its own
+// PORT1_IRQHandler, so in that build port 1 is not dispatched.
+
+#ifndef GPIO_IRQ_H_
+#define GPIO_IRQ_H_
+
+#include <stdint.h>
+
+typedef void (*GpioIrq_Handler)(void *arg);
+
+// Makes an interrupt on any of the given pins call handler(arg), and
+// enables the port's interrupt in the NVIC. port and pins take driverlib's
+// GPIO_PORT_Px and GPIO_PINx values, and each pin has one handler: a later
+// call replaces it. Pass a NULL handler to ignore the pins again.
+//
+// Register before enabling the pins' interrupts with
+// GPIO_enableInterrupt(), which, like the edge, is left to the caller.
+void GpioIrq_register(uint_fast8_t port, uint_fast16_t pins,
+                      GpioIrq_Handler handler, void *arg);
+
+#endif /* GPIO_IRQ_H_ */
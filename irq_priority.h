@@ -0,0 +1,105 @@
+// Interrupt priorities, and critical sections that only mask what they must
+//
+// The MSP432's NVIC has 3 priority bits: 8 levels, 0 the most urgent. An
+// interrupt preempts any handler running at a less urgent level, and waits
+// for one at the same level to return. At reset every interrupt is at level
+// 0, so none can preempt another. Each module enables its interrupts with
+// IrqPriority_enableInterrupt() instead, at its level in the map below.
+//
+// A module whose state is shared with ISRs guards it with
+// IrqPriority_enter()/IrqPriority_exit(), which set BASEPRI to mask only the
+// levels that use the module; more urgent interrupts keep running. So a
+// handler may only call a module whose sections mask the handler's level:
+//
+//   level 1, deadline  - its own state and EventQueue_push() only
+//   level 2, driver    - also SwTimer_*, SleepManager_*, the LCD HAL
+//   level 3, input     - also GpioIrq_register()
+//   level 7, lowest    - anything; the scheduler's PendSV handler
+//
+// Two kinds of sections still disable interrupts altogether: those that
+// check a condition and then sleep (SleepManager_sleep(),
+// HAL_LCD_waitDMA(), HAL_LCD_delayMicroseconds()), since WFI does not wake
+// for an interrupt BASEPRI masks, and the profiler's, which records from
+// every level.
+//
+// Worst-case latency budget per level, from the interrupt going pending to
+// the first instruction of its handler, at 48MHz. Each is the entry itself
+// (12 cycles, up to twice that with flash wait states), plus the longest
+// section that masks the level, plus the longest handler at the same or a
+// more urgent level that may be running. The figures are the limits code at
+// each level must keep to; check them with PROFILING=1 when adding to it.
+//
+//   0 unmasked  ~150 cycles, 3us  only the sections that disable interrupts
+//   1 deadline  ~400 cycles, 8us  + another deadline handler; the ADC
+//                                   stream has a whole sample period, 2ms
+//                                   at 100Hz, before it loses data
+//   2 driver   ~2400 cycles, 50us + SwTimer and LCD HAL sections, and one
+//                                   driver handler: a software timer
+//                                   callback, or a DMA completion that
+//                                   chains the next block or starts the next
+//                                   LCD init step
+//   3 input    ~4800 cycles, 100us + every driver handler that can go off
+//                                   together, and one pin handler
+//
+// The delays scale with 48MHz / MCLK at the slower clock profiles, and a
+// handler is only ever slowed down by levels at or above its own.
+
+#ifndef IRQ_PRIORITY_H_
+#define IRQ_PRIORITY_H_
+
+#include <ti/devices/msp432p4xx/driverlib/driverlib.h>
+
+typedef enum {
+    // Never masked by a section; only the latency benchmark uses it
+    IRQ_LEVEL_UNMASKED = 0,
+    // Sources that lose data when they are late, like a DMA ping-pong
+    // buffer that must be rearmed before the other half fills
+    IRQ_LEVEL_DEADLINE = 1,
+    // Drivers that chain work from their interrupts
+    IRQ_LEVEL_DRIVER = 2,
+    // Pin interrupts, which only start debounce timers
+    IRQ_LEVEL_INPUT = 3,
+    IRQ_LEVEL_LOWEST = 7
+} IrqLevel;
+
+// The priority map
+#define IRQ_LEVEL_ADC_DMA       IRQ_LEVEL_DEADLINE
+#define IRQ_LEVEL_LCD_DMA       IRQ_LEVEL_DRIVER
+#define IRQ_LEVEL_LCD_DELAY     IRQ_LEVEL_DRIVER
+#define IRQ_LEVEL_SW_TIMER      IRQ_LEVEL_DRIVER
+#define IRQ_LEVEL_GPIO          IRQ_LEVEL_INPUT
+// PendSV, which runs the scheduler with SLEEP_ON_EXIT=1
+#define IRQ_LEVEL_SCHEDULER     IRQ_LEVEL_LOWEST
+
+// The level as the NVIC and BASEPRI take it, in the top bits of a byte
+#define IRQ_PRIORITY(level)     ((uint8_t) ((level) << (8 - __NVIC_PRIO_BITS)))
+
+// Sets an interrupt's priority, then enables it
+static inline void IrqPriority_enableInterrupt(uint32_t interruptNumber, IrqLevel level)
+{
+    Interrupt_setPriority(interruptNumber, IRQ_PRIORITY(level));
+    Interrupt_enableInterrupt(interruptNumber);
+}
+
+// Masks the interrupts at the given level and the less urgent ones, and
+// returns the previous mask, for IrqPriority_exit(). Never unmasks a level a
+// section around this one has masked. The level must not be
+// IRQ_LEVEL_UNMASKED, which BASEPRI cannot mask.
+static inline uint8_t IrqPriority_enter(IrqLevel level)
+{
+    uint8_t previous = Interrupt_getPriorityMask();
+    uint8_t mask = IRQ_PRIORITY(level);
+
+    // A mask of 0 masks nothing
+    if (previous == 0 || mask < previous)
+        Interrupt_setPriorityMask(mask);
+
+    return previous;
+}
+
+static inline void IrqPriority_exit(uint8_t previous)
+{
+    Interrupt_setPriorityMask(previous);
+}
+
+#endif /* IRQ_PRIORITY_H_ */
@@ -0,0 +1,134 @@
+#include <ti/devices/msp432p4xx/driverlib/driverlib.h>
+#include "profiler.h"
+
+#if PROFILING
+
+#include "sleep_manager.h"
+#include "timestamp.h"
+
+ProfileStats Profiler_probes[PROFILE_COUNT];
+
+// Timestamp_now() cycles spent awake and asleep since Profiler_init()
+static uint64_t awakeCycles;
+static uint64_t asleepCycles;
+
+// When the current awake or asleep span started
+static uint32_t spanStart;
+
+// DWT->CYCCNT when main woke, while it is awake
+static uint32_t wakeStart;
+static bool awake;
+
+void Profiler_init()
+{
+    int i;
+
+    for (i = 0; i < PROFILE_COUNT; i++)
+        Profiler_resetStats(&Profiler_probes[i]);
+
+    awakeCycles = 0;
+    asleepCycles = 0;
+    awake = false;
+
+    // The Timestamp counter stops in LPM3, which would hide the time spent there
+    SleepManager_blockLPM3(SLEEP_BLOCKER_PROFILER);
+
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+
+    spanStart = Timestamp_now();
+}
+
+void Profiler_record(ProfileProbe probe, uint32_t cycles)
+{
+    Profiler_addCycles(&Profiler_probes[probe], cycles);
+}
+
+void Profiler_addCycles(ProfileStats *stats, uint32_t cycles)
+{
+    // Probes in ISRs can interrupt a probe in main halfway through its update
+    bool wasDisabled = Interrupt_disableMaster();
+
+    stats->calls++;
+    stats->totalCycles += cycles;
+    if (cycles < stats->minCycles)
+        stats->minCycles = cycles;
+    if (cycles > stats->maxCycles)
+        stats->maxCycles = cycles;
+
+    if (!wasDisabled)
+        Interrupt_enableMaster();
+}
+
+void Profiler_resetStats(ProfileStats *stats)
+{
+    stats->calls = 0;
+    stats->minCycles = UINT32_MAX;
+    stats->maxCycles = 0;
+    stats->totalCycles = 0;
+}
+
+uint32_t Profiler_averageCycles(ProfileProbe probe)
+{
+    const ProfileStats *stats = &Profiler_probes[probe];
+
+    if (stats->calls == 0)
+        return 0;
+
+    return (uint32_t) (stats->totalCycles / stats->calls);
+}
+
+// Both are called with interrupts disabled
+void Profiler_sleepBegin()
+{
+    uint32_t now = Timestamp_now();
+
+    awakeCycles += now - spanStart;
+    spanStart = now;
+}
+
+void Profiler_sleepEnd()
+{
+    uint32_t now = Timestamp_now();
+
+    asleepCycles += now - spanStart;
+    spanStart = now;
+}
+
+uint32_t Profiler_cpuLoadPercent()
+{
+    uint64_t total = awakeCycles + asleepCycles;
+
+    if (total == 0)
+        return 0;
+
+    return (uint32_t) (awakeCycles * 100 / total);
+}
+
+// Only main calls these
+void Profiler_wakeBegin()
+{
+    wakeStart = DWT->CYCCNT;
+    awake = true;
+}
+
+void Profiler_wakeEnd()
+{
+    // The first call comes before main has ever slept
+    if (awake)
+        Profiler_record(PROFILE_WAKE, DWT->CYCCNT - wakeStart);
+    awake = false;
+}
+
+uint32_t Profiler_wakeOverheadPerEvent()
+{
+    const ProfileStats *wake = &Profiler_probes[PROFILE_WAKE];
+    const ProfileStats *event = &Profiler_probes[PROFILE_EVENT];
+
+    if (event->calls == 0)
+        return 0;
+
+    return (uint32_t) ((wake->totalCycles - event->totalCycles) / event->calls);
+}
+
+#endif
@@ -0,0 +1,121 @@
+// Cycle-count instrumentation for ISRs and the LCD driver
+//
+// Build with PROFILING=1 in the project's predefined symbols to enable it.
+// Each probe then records how many times it ran and the fewest, most and
+// total DWT CYCCNT cycles it took, in Profiler_probes[], to be read with
+// the debugger. The cycles of any interrupt that nests inside a probe are
+// counted as part of it.
+//
+// The profiler also splits time into awake and asleep around
+// SleepManager_sleep(), for a CPU load figure. That uses the Timestamp
+// counter, which stops in LPM3, so while profiling LPM3 is blocked and the
+// device only sleeps in LPM0.
+//
+// Two probes compare the normal main loop with SLEEP_ON_EXIT=1: PROFILE_WAKE
+// adds up what main does from one sleep to the next (or what the
+// scheduler's PendSV handler does), and PROFILE_EVENT the event handlers
+// run in it. Profiler_wakeOverheadPerEvent() is what is left per event; the
+// difference between the two builds is what sleeping on exit saves. With
+// SLEEP_ON_EXIT=1 main never sleeps itself, so there is no CPU load figure.
+//
+// With PROFILING=0 (the default) the macros below expand to nothing and
+// none of this is compiled in.
+
+#ifndef PROFILER_H_
+#define PROFILER_H_
+
+#include <stdint.h>
+
+#ifndef PROFILING
+#define PROFILING 0
+#endif
+
+typedef enum {
+    PROFILE_PORT1_ISR,
+    PROFILE_TIMER_EXPIRED,
+    PROFILE_LCD_PIXEL_DRAW,
+    PROFILE_LCD_PIXEL_DRAW_MULTIPLE,
+    PROFILE_LCD_LINE_DRAW_H,
+    PROFILE_LCD_LINE_DRAW_V,
+    PROFILE_LCD_RECT_FILL,
+    PROFILE_LCD_COLOR_TRANSLATE,
+    PROFILE_LCD_FLUSH,
+    PROFILE_LCD_CLEAR_SCREEN,
+    PROFILE_LCD_WRITE_COMMAND,
+    PROFILE_WAKE,
+    PROFILE_EVENT,
+    PROFILE_COUNT
+} ProfileProbe;
+
+typedef struct {
+    uint32_t calls;
+    uint32_t minCycles;
+    uint32_t maxCycles;
+    uint64_t totalCycles;
+} ProfileStats;
+
+#if PROFILING
+
+#include <ti/devices/msp432p4xx/inc/msp.h>
+
+extern ProfileStats Profiler_probes[PROFILE_COUNT];
+
+// Starts the cycle counter, clears all statistics and blocks LPM3. Call
+// after Timestamp_init().
+void Profiler_init();
+
+// Adds one run of the given number of cycles to a probe. Safe to call from
+// ISRs.
+void Profiler_record(ProfileProbe probe, uint32_t cycles);
+
+// The same, for statistics kept outside Profiler_probes[], such as those
+// of scheduler tasks. Clear them with Profiler_resetStats() first.
+void Profiler_addCycles(ProfileStats *stats, uint32_t cycles);
+void Profiler_resetStats(ProfileStats *stats);
+
+// Returns the average number of cycles a probe took, or 0 if it never ran
+uint32_t Profiler_averageCycles(ProfileProbe probe);
+
+// Called by SleepManager_sleep() just before and just after sleeping
+void Profiler_sleepBegin();
+void Profiler_sleepEnd();
+
+// Returns the share of time spent awake since Profiler_init(), in percent
+uint32_t Profiler_cpuLoadPercent();
+
+// Called by SleepManager_sleep() once the ISRs that woke the core have run,
+// and just before it checks for work again
+void Profiler_wakeBegin();
+void Profiler_wakeEnd();
+
+// Returns the cycles of PROFILE_WAKE outside the event handlers, per event
+// handled, or 0 if none was
+uint32_t Profiler_wakeOverheadPerEvent();
+
+// Put PROFILE_BEGIN(probe) at the start of the code to measure and
+// PROFILE_END(probe) at the end, in the same block. PROFILE_END_STATS(name,
+// stats) ends a PROFILE_BEGIN(name) into the ProfileStats at stats instead.
+#define PROFILE_INIT()          Profiler_init()
+#define PROFILE_BEGIN(probe)    uint32_t profileStart_##probe = DWT->CYCCNT
+#define PROFILE_END(probe)      Profiler_record(probe, DWT->CYCCNT - profileStart_##probe)
+#define PROFILE_END_STATS(name, stats) \
+        Profiler_addCycles(stats, DWT->CYCCNT - profileStart_##name)
+#define PROFILE_SLEEP_BEGIN()   Profiler_sleepBegin()
+#define PROFILE_SLEEP_END()     Profiler_sleepEnd()
+#define PROFILE_WAKE_BEGIN()    Profiler_wakeBegin()
+#define PROFILE_WAKE_END()      Profiler_wakeEnd()
+
+#else
+
+#define PROFILE_INIT()
+#define PROFILE_BEGIN(probe)
+#define PROFILE_END(probe)
+#define PROFILE_END_STATS(name, stats)
+#define PROFILE_SLEEP_BEGIN()
+#define PROFILE_SLEEP_END()
+#define PROFILE_WAKE_BEGIN()
+#define PROFILE_WAKE_END()
+
+#endif
+
+#endif /* PROFILER_H_ */
@@ -0,0 +1,26 @@
+// Runs a function from SRAM instead of flash
+//
+// Put RAMFUNC in front of a function definition to have the linker place it
+// in .TI.ramfunc, which msp432p401r.cmd loads into flash and copies to
+// SRAM_CODE at boot. Code there runs without flash wait states, which at
+// 48MHz cost a cycle or more on every instruction fetch that misses the
+// flash buffer. Whatever a RAMFUNC calls still runs from wherever it is.
+//
+// Build with USE_RAMFUNC=0 to leave everything in flash, to compare the two.
+// tools/ramfunc_report.py lists what ended up in SRAM, from the map file.
+
+#ifndef RAMFUNC_H_
+#define RAMFUNC_H_
+
+#ifndef USE_RAMFUNC
+#define USE_RAMFUNC 1
+#endif
+
+// The section needs TI compiler 15.9 or later, like msp432p401r.cmd
+#if USE_RAMFUNC && defined(__TI_COMPILER_VERSION__) && __TI_COMPILER_VERSION__ >= 15009000
+#define RAMFUNC __attribute__((ramfunc))
+#else
+#define RAMFUNC
+#endif
+
+#endif /* RAMFUNC_H_ */
@@ -0,0 +1,86 @@
+#include <stddef.h>
+#include <ti/devices/msp432p4xx/driverlib/driverlib.h>
+#include "irq_priority.h"
+#include "ramfunc.h"
+#include "scheduler.h"
+#include "sleep_manager.h"
+
+// By priority; NULL where there is no task
+static SchedulerTask *tasks[SCHEDULER_MAX_TASKS];
+
+void Scheduler_init()
+{
+#if SLEEP_ON_EXIT
+    // So that the handlers never hold back an interrupt
+    Interrupt_setPriority(FAULT_PENDSV, IRQ_PRIORITY(IRQ_LEVEL_SCHEDULER));
+#endif
+}
+
+bool Scheduler_addTask(SchedulerTask *task, unsigned priority,
+                       EventQueue *queue, Scheduler_Handler handler)
+{
+    if (priority >= SCHEDULER_MAX_TASKS || tasks[priority] != NULL)
+        return false;
+
+    task->queue = queue;
+    task->handler = handler;
+#if PROFILING
+    Profiler_resetStats(&task->runtime);
+#endif
+
+    tasks[priority] = task;
+
+    return true;
+}
+
+RAMFUNC bool Scheduler_dispatch()
+{
+    unsigned priority;
+
+    for (priority = 0; priority < SCHEDULER_MAX_TASKS; priority++) {
+        SchedulerTask *task = tasks[priority];
+        Event event;
+
+        if (task == NULL || !EventQueue_pop(task->queue, &event))
+            continue;
+
+        PROFILE_BEGIN(PROFILE_EVENT);
+        PROFILE_BEGIN(handler);
+        task->handler(&event);
+        PROFILE_END_STATS(handler, &task->runtime);
+        PROFILE_END(PROFILE_EVENT);
+        return true;
+    }
+
+    return false;
+}
+
+bool Scheduler_pending()
+{
+    unsigned priority;
+
+    for (priority = 0; priority < SCHEDULER_MAX_TASKS; priority++) {
+        if (tasks[priority] != NULL && !EventQueue_isEmpty(tasks[priority]->queue))
+            return true;
+    }
+
+    return false;
+}
+
+#if SLEEP_ON_EXIT
+// EventQueue_push() pends PendSV for every event. It runs once every other
+// handler has returned and handles everything queued; an ISR that queues an
+// event while it runs pends it again.
+RAMFUNC void PendSV_Handler()
+{
+    PROFILE_BEGIN(PROFILE_WAKE);
+
+    while (Scheduler_dispatch())
+        ;
+
+    // A handler that waited in LPM0 cleared SLEEPDEEP
+    SleepManager_updateSleepDeep();
+
+    PROFILE_END(PROFILE_WAKE);
+}
+#endif
@@ -0,0 +1,61 @@
+// A run-to-completion scheduler for the events queued by the ISRs
+//
+// Every task owns one event queue and a handler. Scheduler_dispatch() runs
+// the handler on the oldest event of the highest-priority task that has
+// any, and handlers run until they return, so they never interrupt each
+// other; only ISRs can. main calls Scheduler_dispatch() until it finds
+// nothing to do, then sleeps with SleepManager_sleep(Scheduler_pending),
+// which checks the queues with interrupts disabled so an event that comes
+// in just before the sleep still wakes it.
+//
+// With SLEEP_ON_EXIT=1 there is no main loop: every event pends PendSV,
+// whose handler dispatches until the queues are empty. It runs at
+// IRQ_LEVEL_SCHEDULER, below every interrupt, so handlers still never
+// interrupt each other and any ISR can interrupt them.
+//
+// When built with PROFILING=1, each task also keeps the cycles its handler
+// takes per event. The queues keep their own high-water marks.
+
+#ifndef SCHEDULER_H_
+#define SCHEDULER_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "event_queue.h"
+#include "profiler.h"
+
+// Number of priorities, and so of tasks. Priority 0 is the most urgent.
+#ifndef SCHEDULER_MAX_TASKS
+#define SCHEDULER_MAX_TASKS 8
+#endif
+
+typedef void (*Scheduler_Handler)(const Event *event);
+
+typedef struct {
+    // Only the scheduler should touch these
+    EventQueue *queue;
+    Scheduler_Handler handler;
+
+#if PROFILING
+    // Cycles taken by the handler, per event
+    ProfileStats runtime;
+#endif
+} SchedulerTask;
+
+// Sets up the scheduler. Call once from main, before enabling any ISR that
+// queues events: with SLEEP_ON_EXIT=1, queuing an event pends PendSV.
+void Scheduler_init();
+
+// Adds a task that runs handler on every event of queue. Only call from
+// main. Returns false if priority is out of range or already taken.
+bool Scheduler_addTask(SchedulerTask *task, unsigned priority,
+                       EventQueue *queue, Scheduler_Handler handler);
+
+// Handles one event of the most urgent task that has any. Returns false,
+// without doing anything, if every queue is empty.
+bool Scheduler_dispatch();
+
+// Returns true if any task has an event waiting
+bool Scheduler_pending();
+
+#endif /* SCHEDULER_H_ */
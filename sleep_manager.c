@@ -0,0 +1,105 @@
+#include <ti/devices/msp432p4xx/driverlib/driverlib.h>
+#include "irq_priority.h"
+#include "profiler.h"
+#include "sleep_manager.h"
+
+static volatile uint32_t lpm3Blockers = 0;
+
+#if SLEEP_ON_EXIT
+static bool sleepingOnExit = false;
+
+// Once the core sleeps on its own, SLEEPDEEP picks LPM3 or LPM0; LPM3 is
+// what SleepManager_sleepOnExit() set the PCM's LPMR to, since
+// PCM_gotoLPM3() is never called in this build. Setting SLEEPDEEP directly
+// also skips that function's power state checks, so the clock profile must
+// allow LPM3. Only call with the blockers masked.
+static void applySleepDeep()
+{
+    if (sleepingOnExit && lpm3Blockers == 0)
+        SCB->SCR |= SCB_SCR_SLEEPDEEP_Msk;
+    else
+        SCB->SCR &= ~SCB_SCR_SLEEPDEEP_Msk;
+}
+#endif
+
+void SleepManager_blockLPM3(uint32_t reasons)
+{
+    // An ISR could change the mask between our read and our write. The
+    // drivers' ISRs are the most urgent that block LPM3.
+    uint8_t previousMask = IrqPriority_enter(IRQ_LEVEL_DRIVER);
+    lpm3Blockers |= reasons;
+#if SLEEP_ON_EXIT
+    applySleepDeep();
+#endif
+    IrqPriority_exit(previousMask);
+}
+
+void SleepManager_unblockLPM3(uint32_t reasons)
+{
+    uint8_t previousMask = IrqPriority_enter(IRQ_LEVEL_DRIVER);
+    lpm3Blockers &= ~reasons;
+#if SLEEP_ON_EXIT
+    applySleepDeep();
+#endif
+    IrqPriority_exit(previousMask);
+}
+
+void SleepManager_sleep(bool (*workPending)())
+{
+    // With interrupts disabled, an interrupt that becomes pending still wakes
+    // the core from WFI; its handler runs once interrupts are enabled again.
+    // So nothing can slip in between the check and going to sleep. A
+    // BASEPRI mask would not do: WFI does not wake for what it masks.
+    Interrupt_disableMaster();
+    PROFILE_WAKE_END();
+
+    if (!workPending()) {
+        PROFILE_SLEEP_BEGIN();
+
+        // PCM_gotoLPM3() returns false without sleeping if the power state
+        // does not allow the transition; LPM0 always works
+        if (lpm3Blockers != 0 || !PCM_gotoLPM3())
+            PCM_gotoLPM0();
+
+        PROFILE_SLEEP_END();
+    }
+
+    Interrupt_enableMaster();
+
+    // The ISRs that woke the core have run; the rest is main's
+    PROFILE_WAKE_BEGIN();
+}
+
+#if SLEEP_ON_EXIT
+void SleepManager_sleepOnExit()
+{
+    uint8_t previousMask;
+
+    // A deep sleep enters the mode LPMR selects. It resets to LPM3, but
+    // nothing here should depend on that. LPMR cannot change while the PCM
+    // is busy with a power mode request.
+    while (PCM->CTL1 & PCM_CTL1_PMR_BUSY)
+        ;
+    PCM->CTL0 = PCM_CTL0_KEY_VAL | PCM_CTL0_LPMR__LPM3 |
+                (PCM->CTL0 & ~(PCM_CTL0_KEY_MASK | PCM_CTL0_LPMR_MASK));
+
+    previousMask = IrqPriority_enter(IRQ_LEVEL_DRIVER);
+    sleepingOnExit = true;
+    applySleepDeep();
+    IrqPriority_exit(previousMask);
+
+    Interrupt_enableSleepOnIsrExit();
+
+    // The first interrupt ends this sleep, but when its handler returns the
+    // core sleeps again instead of coming back here
+    while (1)
+        CPU_wfi();
+}
+
+void SleepManager_updateSleepDeep()
+{
+    uint8_t previousMask = IrqPriority_enter(IRQ_LEVEL_DRIVER);
+    applySleepDeep();
+    IrqPriority_exit(previousMask);
+}
+#endif
@@ -0,0 +1,60 @@
+// Picks the deepest low power mode the application allows
+//
+// The device sleeps in LPM3 unless some part of the application has blocked
+// it, in which case it sleeps in LPM0. In LPM3 MCLK, SMCLK and HSMCLK are
+// off; only ACLK (REFO, 32768Hz) peripherals such as the WDT_A interval
+// timer, and wakeups such as port interrupts, keep working. Anything that
+// needs the high-frequency clocks while the CPU sleeps, like an SPI or DMA
+// transfer in flight, must block LPM3 for as long as it runs.
+
+#ifndef SLEEP_MANAGER_H_
+#define SLEEP_MANAGER_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Build with SLEEP_ON_EXIT=1 to run the application from interrupts only,
+// with SleepManager_sleepOnExit() instead of a main loop
+#ifndef SLEEP_ON_EXIT
+#define SLEEP_ON_EXIT 0
+#endif
+
+// The reasons LPM3 can be blocked for, one bit each. Add a bit here for
+// every module that needs to block it.
+#define SLEEP_BLOCKER_APP       (1u << 0)
+#define SLEEP_BLOCKER_SW_TIMER  (1u << 1)
+#define SLEEP_BLOCKER_PROFILER  (1u << 2)
+#define SLEEP_BLOCKER_LCD       (1u << 3)
+#define SLEEP_BLOCKER_ADC       (1u << 4)
+
+// Prevents LPM3 for the given reasons, until they are unblocked. Safe to
+// call from ISRs.
+void SleepManager_blockLPM3(uint32_t reasons);
+
+// Allows LPM3 again for the given reasons. Safe to call from ISRs.
+void SleepManager_unblockLPM3(uint32_t reasons);
+
+// Sleeps until the next interrupt, unless workPending() says there is
+// already something to do. workPending() is called with interrupts
+// disabled, so an interrupt that arrives after it returns false still ends
+// the sleep instead of waiting for the next one. Returns once the device is
+// awake and interrupts have been handled.
+void SleepManager_sleep(bool (*workPending)());
+
+#if SLEEP_ON_EXIT
+// Sets the core's SLEEPONEXIT bit and goes to sleep. Never returns: from
+// then on the core goes back to sleep as soon as the last handler returns,
+// without going through main, so every event is handled in an ISR or in the
+// scheduler's PendSV handler. The sleep is LPM3 unless blocked, as with
+// SleepManager_sleep(); which one is set by the core's SLEEPDEEP bit, kept
+// in step with the blockers. Unlike PCM_gotoLPM3(), nothing checks that the
+// power state allows LPM3, so stay at VCORE0: not in CLOCK_PROFILE_48MHZ.
+void SleepManager_sleepOnExit();
+
+// Sets SLEEPDEEP for the current blockers again. PCM_gotoLPM0(), which the
+// LCD HAL uses to wait, clears it; the scheduler calls this after every
+// pass.
+void SleepManager_updateSleepDeep();
+#endif
+
+#endif /* SLEEP_MANAGER_H_ */
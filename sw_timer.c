@@ -0,0 +1,324 @@
+#include <ti/devices/msp432p4xx/driverlib/driverlib.h>
+#include "clock_profile.h"
+#include "irq_priority.h"
+#include "sleep_manager.h"
+#include "sw_timer.h"
+#include "vector_table.h"
+
+#define SLOT_MASK (SW_TIMER_SLOTS - 1)
+
+// Timers are hashed into the slot of their expiry tick. A slot holds the
+// timers of every revolution of the wheel, so the ones that are not due yet
+// are skipped when it is visited.
+static SwTimer *slots[SW_TIMER_SLOTS];
+static uint32_t occupied = 0;
+static unsigned activeCount = 0;
+
+// The hardware one-shot started counting at tick baseTick and expires
+// periodCycles MCLK cycles later, at tick armedTick
+static bool running = false;
+static uint32_t baseTick = 0;
+static uint32_t armedTick;
+static uint32_t periodCycles;
+
+// Every timer expiring at or before this tick has been handled
+static uint32_t processedTick = 0;
+
+static uint32_t cyclesPerTick;
+
+static void link(SwTimer *timer)
+{
+    unsigned slot = timer->expires & SLOT_MASK;
+
+    timer->prev = 0;
+    timer->next = slots[slot];
+    if (timer->next)
+        timer->next->prev = timer;
+    slots[slot] = timer;
+
+    occupied |= 1u << slot;
+    timer->active = true;
+    activeCount++;
+}
+
+static void unlink(SwTimer *timer)
+{
+    unsigned slot = timer->expires & SLOT_MASK;
+
+    if (timer->prev)
+        timer->prev->next = timer->next;
+    else
+        slots[slot] = timer->next;
+    if (timer->next)
+        timer->next->prev = timer->prev;
+
+    if (slots[slot] == 0)
+        occupied &= ~(1u << slot);
+    timer->active = false;
+    activeCount--;
+}
+
+static uint32_t usToTicks(uint32_t us)
+{
+    uint32_t ticks = (us + SW_TIMER_TICK_US - 1) / SW_TIMER_TICK_US;
+
+    return ticks ? ticks : 1;
+}
+
+static uint32_t elapsedCycles()
+{
+    return periodCycles - Timer32_getValue(TIMER32_0_BASE);
+}
+
+static uint32_t currentTick()
+{
+    if (!running)
+        return baseTick;
+
+    return baseTick + elapsedCycles() / cyclesPerTick;
+}
+
+// Finds the earliest expiry tick of the active timers. Going through the
+// occupied slots in the order they come up, the first timer due within the
+// current revolution is the answer.
+static uint32_t nextDeadline(uint32_t now)
+{
+    uint32_t nearest = UINT32_MAX;
+    unsigned distance;
+
+    for (distance = 1; distance <= SW_TIMER_SLOTS; distance++) {
+        unsigned slot = (now + distance) & SLOT_MASK;
+        SwTimer *timer;
+
+        if (!(occupied & (1u << slot)))
+            continue;
+
+        for (timer = slots[slot]; timer; timer = timer->next) {
+            uint32_t left = timer->expires - now;
+
+            if (left == distance)
+                return timer->expires;
+            if (left < nearest)
+                nearest = left;
+        }
+    }
+
+    return now + nearest;
+}
+
+// Programs the hardware to expire at the given tick, keeping the current
+// base when it is running so that no elapsed time is lost
+static void arm(uint32_t deadline)
+{
+    uint32_t elapsed = 0;
+    uint32_t maxTicks = UINT32_MAX / cyclesPerTick;
+
+    if (running)
+        elapsed = elapsedCycles();
+
+    Timer32_haltTimer(TIMER32_0_BASE);
+
+    // Deadlines further than the counter can reach take several wakeups
+    if (deadline - baseTick > maxTicks)
+        deadline = baseTick + maxTicks;
+
+    armedTick = deadline;
+    periodCycles = (deadline - baseTick) * cyclesPerTick;
+    running = true;
+
+    Timer32_setCount(TIMER32_0_BASE, elapsed < periodCycles ? periodCycles - elapsed : 1);
+    Timer32_startTimer(TIMER32_0_BASE, true);
+}
+
+static void stop()
+{
+    baseTick = currentTick();
+    Timer32_haltTimer(TIMER32_0_BASE);
+    running = false;
+}
+
+// Makes the hardware and the sleep manager agree with the active timers
+static void update()
+{
+    if (activeCount == 0) {
+        if (running)
+            stop();
+        SleepManager_unblockLPM3(SLEEP_BLOCKER_SW_TIMER);
+        return;
+    }
+
+    SleepManager_blockLPM3(SLEEP_BLOCKER_SW_TIMER);
+
+    {
+        uint32_t deadline = nextDeadline(currentTick());
+
+        if (!running || (int32_t) (deadline - armedTick) < 0)
+            arm(deadline);
+    }
+}
+
+// Takes one timer due by now off the slots of the given ticks, or returns 0
+// if there are none left. Periodic timers go straight back on the wheel, so
+// their callback can still cancel or restart them.
+static SwTimer *takeExpired(uint32_t from, uint32_t ticks, uint32_t now)
+{
+    uint32_t i;
+
+    for (i = 1; i <= ticks; i++) {
+        SwTimer *timer;
+
+        for (timer = slots[(from + i) & SLOT_MASK]; timer; timer = timer->next) {
+            if ((int32_t) (timer->expires - now) <= 0) {
+                unlink(timer);
+                if (timer->period) {
+                    timer->expires += timer->period;
+                    if ((int32_t) (timer->expires - now) <= 0)
+                        timer->expires = now + timer->period;
+                    link(timer);
+                }
+                return timer;
+            }
+        }
+    }
+
+    return 0;
+}
+
+static void SwTimer_interrupt()
+{
+    uint32_t now, from, ticks;
+    uint8_t previousMask;
+
+    Timer32_clearInterruptFlag(TIMER32_0_BASE);
+
+    previousMask = IrqPriority_enter(IRQ_LEVEL_SW_TIMER);
+
+    // The hardware stopped at armedTick, which becomes the new base
+    baseTick = armedTick;
+    running = false;
+    now = baseTick;
+
+    // Every slot has been visited after one revolution
+    from = processedTick;
+    ticks = now - processedTick;
+    if (ticks > SW_TIMER_SLOTS)
+        ticks = SW_TIMER_SLOTS;
+
+    // Callbacks run unmasked, one timer at a time, so they can start and
+    // cancel any timer; the ones they start are not due yet
+    while (1) {
+        SwTimer *timer = takeExpired(from, ticks, now);
+        SwTimer_Callback callback;
+        void *arg;
+
+        if (!timer)
+            break;
+
+        callback = timer->callback;
+        arg = timer->arg;
+
+        IrqPriority_exit(previousMask);
+        callback(arg);
+        previousMask = IrqPriority_enter(IRQ_LEVEL_SW_TIMER);
+    }
+
+    processedTick = now;
+    update();
+
+    IrqPriority_exit(previousMask);
+}
+
+// MCLK changed: count the elapsed time at the old rate and rearm at the new
+static void clockChanged()
+{
+    uint8_t previousMask = IrqPriority_enter(IRQ_LEVEL_SW_TIMER);
+
+    if (running) {
+        stop();
+        cyclesPerTick = SystemCoreClock / (1000000 / SW_TIMER_TICK_US);
+        arm(armedTick);
+    }
+    else
+        cyclesPerTick = SystemCoreClock / (1000000 / SW_TIMER_TICK_US);
+
+    IrqPriority_exit(previousMask);
+}
+
+#if STATIC_VECTOR_TABLE
+// Bound by name in the flash vector table, instead of registered in SwTimer_init()
+void T32_INT1_IRQHandler()
+{
+    SwTimer_interrupt();
+}
+#endif
+
+void SwTimer_init()
+{
+    cyclesPerTick = SystemCoreClock / (1000000 / SW_TIMER_TICK_US);
+
+    Timer32_initModule(TIMER32_0_BASE, // There are two timers, we are using the one with the index 0
+                       TIMER32_PRESCALER_1, // The prescaler value is 1; The clock is not divided before feeding the counter
+                       TIMER32_32BIT, // The counter is used in 32-bit mode; the alternative is 16-bit mode
+                       TIMER32_PERIODIC_MODE); //This options is irrelevant for a one-shot timer
+
+#if !STATIC_VECTOR_TABLE
+    Timer32_registerInterrupt(INT_T32_INT1, SwTimer_interrupt);
+#endif
+    Timer32_clearInterruptFlag(TIMER32_0_BASE);
+    IrqPriority_enableInterrupt(INT_T32_INT1, IRQ_LEVEL_SW_TIMER);
+
+    ClockProfile_subscribe(clockChanged);
+}
+
+void SwTimer_start(SwTimer *timer, uint32_t delayUs, uint32_t periodUs,
+                   SwTimer_Callback callback, void *arg)
+{
+    uint8_t previousMask = IrqPriority_enter(IRQ_LEVEL_SW_TIMER);
+
+    if (timer->active)
+        unlink(timer);
+
+    // Nothing due before now is still on the wheel, so the wheel can be
+    // considered processed up to now
+    if (activeCount == 0)
+        processedTick = currentTick();
+
+    // While the hardware runs, part of the current tick has already gone;
+    // one more tick makes sure the delay is never short
+    timer->expires = currentTick() + usToTicks(delayUs) + (running ? 1 : 0);
+    timer->period = periodUs ? usToTicks(periodUs) : 0;
+    timer->callback = callback;
+    timer->arg = arg;
+    link(timer);
+
+    update();
+
+    IrqPriority_exit(previousMask);
+}
+
+void SwTimer_cancel(SwTimer *timer)
+{
+    uint8_t previousMask = IrqPriority_enter(IRQ_LEVEL_SW_TIMER);
+
+    if (timer->active) {
+        unlink(timer);
+        update();
+    }
+
+    IrqPriority_exit(previousMask);
+}
+
+bool SwTimer_isActive(const SwTimer *timer)
+{
+    return timer->active;
+}
+
+uint32_t SwTimer_now()
+{
+    uint8_t previousMask = IrqPriority_enter(IRQ_LEVEL_SW_TIMER);
+
+    uint32_t now = currentTick();
+
+    IrqPriority_exit(previousMask);
+    return now;
+}
@@ -0,0 +1,60 @@
+// Software timers multiplexed on Timer32_0
+//
+// Any number of one-shot and periodic timers share the hardware timer. They
+// are kept in a hashed timer wheel, so starting and cancelling a timer take
+// constant time. There is no periodic tick: Timer32_0 is programmed as a
+// one-shot for the nearest deadline, and does not run at all when no timer
+// is active.
+//
+// Time is counted in ticks of SW_TIMER_TICK_US microseconds. A timer expires
+// no earlier than asked, and at most a tick later. Timer32 runs from MCLK, which stops in LPM3,
+// so LPM3 is blocked while any timer is active. Callbacks run in the
+// Timer32 ISR: keep them short, e.g. push an event for main.
+
+#ifndef SW_TIMER_H_
+#define SW_TIMER_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Length of a tick, in microseconds
+#ifndef SW_TIMER_TICK_US
+#define SW_TIMER_TICK_US 1000
+#endif
+
+// Number of wheel slots; one per bit of a 32-bit occupancy mask
+#define SW_TIMER_SLOTS 32
+
+typedef void (*SwTimer_Callback)(void *arg);
+
+// The caller owns the storage of each timer; the fields are private
+typedef struct SwTimer {
+    struct SwTimer *next;
+    struct SwTimer *prev;
+    uint32_t expires;
+    uint32_t period;
+    SwTimer_Callback callback;
+    void *arg;
+    bool active;
+} SwTimer;
+
+// Sets up Timer32_0 and its interrupt. Call once, before any other function.
+void SwTimer_init();
+
+// Starts, or restarts, a timer that calls callback(arg) after delayUs, and
+// then every periodUs if periodUs is not 0. Safe to call from ISRs,
+// including from a timer callback.
+void SwTimer_start(SwTimer *timer, uint32_t delayUs, uint32_t periodUs,
+                   SwTimer_Callback callback, void *arg);
+
+// Stops a timer. Does nothing if it is not active. Safe to call from ISRs.
+void SwTimer_cancel(SwTimer *timer);
+
+// Returns true if the timer is waiting to expire
+bool SwTimer_isActive(const SwTimer *timer);
+
+// Returns the current time in ticks. Time only moves while a timer is
+// active.
+uint32_t SwTimer_now();
+
+#endif /* SW_TIMER_H_ */
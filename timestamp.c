@@ -0,0 +1,18 @@
+#include <ti/devices/msp432p4xx/driverlib/driverlib.h>
+#include "timestamp.h"
+
+void Timestamp_init()
+{
+    Timer32_initModule(TIMER32_1_BASE,
+                       TIMER32_PRESCALER_1,
+                       TIMER32_32BIT,
+                       TIMER32_FREE_RUN_MODE);
+
+    // Free-running mode starts at 0xFFFFFFFF and wraps around
+    Timer32_startTimer(TIMER32_1_BASE, false);
+}
+
+uint32_t Timestamp_now()
+{
+    return ~Timer32_getValue(TIMER32_1_BASE);
+}
@@ -0,0 +1,19 @@
+// A free-running timestamp counter for ordering and timing events
+//
+// Timer32_1 counts down from 0xFFFFFFFF at MCLK with no interrupts; its
+// complement counts up from 0 and wraps every 2^32 MCLK cycles (about 24
+// minutes at 3MHz). Compare timestamps by subtracting them, never with < or >.
+// MCLK, and so the counter, stops in LPM3: time spent there does not count.
+
+#ifndef TIMESTAMP_H_
+#define TIMESTAMP_H_
+
+#include <stdint.h>
+
+// Starts the counter. Timer32_1 must not be used for anything else.
+void Timestamp_init();
+
+// Returns the current timestamp, in MCLK cycles
+uint32_t Timestamp_now();
+
+#endif /* TIMESTAMP_H_ */
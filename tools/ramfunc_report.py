@@ -0,0 +1,51 @@
+#!/usr/bin/env python3
+"""Lists the functions placed in SRAM by RAMFUNC, from a TI linker map file.
+
+Usage: ramfunc_report.py Debug/basic_example_interrupts.map
+"""
+
+import re
+import sys
+
+# An input section line in the section allocation map, for example
+#                   00000e54    0000003c     file.obj (.TI.ramfunc:HAL_LCD_writeData)
+INPUT_SECTION = re.compile(r'^\s+([0-9a-fA-F]{8})\s+([0-9a-fA-F]{8})\s+(\S+)\s+\(([^)]*)\)')
+
+# The first line of an output section starts in column 0
+OUTPUT_SECTION = re.compile(r'^(\S+)')
+
+
+def ramfunc_sections(lines):
+    inside = False
+    for line in lines:
+        match = OUTPUT_SECTION.match(line)
+        if match and match.group(1) != '*':
+            inside = match.group(1) == '.TI.ramfunc'
+            continue
+        if not inside:
+            continue
+
+        match = INPUT_SECTION.match(line)
+        if match and match.group(4).startswith('.TI.ramfunc'):
+            name = match.group(4).partition(':')[2] or '(unnamed)'
+            yield name, match.group(3), int(match.group(2), 16)
+
+
+def main():
+    if len(sys.argv) != 2:
+        sys.exit(__doc__.strip())
+
+    with open(sys.argv[1]) as map_file:
+        sections = list(ramfunc_sections(map_file))
+
+    if not sections:
+        print('Nothing in .TI.ramfunc; was the project built with USE_RAMFUNC=0?')
+        return
+
+    for name, obj, size in sorted(sections, key=lambda s: -s[2]):
+        print('%6d  %-40s %s' % (size, name, obj))
+    print('%6d  total bytes of SRAM_CODE' % sum(s[2] for s in sections))
+
+
+if __name__ == '__main__':
+    main()
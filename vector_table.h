@@ -0,0 +1,48 @@
+// Chooses how ISRs are bound to their interrupts
+//
+// By default a module may bind its ISR at runtime with one of driverlib's
+// *_registerInterrupt() functions. The first such call copies the whole
+// vector table to the .vtable section at 0x20000000 and switches VTOR to it,
+// which takes time at boot and ties up that SRAM for good.
+//
+// Build with STATIC_VECTOR_TABLE=1 to bind every ISR by name instead: a
+// function called, for example, T32_INT1_IRQHandler replaces the weak alias
+// in the flash interruptVectors table in ccs/startup_msp432p401r_ccs.c. In
+// that mode, including this header (after driverlib) turns every
+// *_registerInterrupt() call into a compile error. To check the whole
+// project, add --preinclude=vector_table.h to the compiler options.
+
+#ifndef VECTOR_TABLE_H_
+#define VECTOR_TABLE_H_
+
+#include <ti/devices/msp432p4xx/driverlib/driverlib.h>
+
+#ifndef STATIC_VECTOR_TABLE
+#define STATIC_VECTOR_TABLE 0
+#endif
+
+#if STATIC_VECTOR_TABLE
+
+// Each of these expands to an undeclared identifier that names the problem
+#define Interrupt_registerInterrupt(...)    STATIC_VECTOR_TABLE_forbids_registerInterrupt
+#define ADC14_registerInterrupt(...)        STATIC_VECTOR_TABLE_forbids_registerInterrupt
+#define AES256_registerInterrupt(...)       STATIC_VECTOR_TABLE_forbids_registerInterrupt
+#define COMP_E_registerInterrupt(...)       STATIC_VECTOR_TABLE_forbids_registerInterrupt
+#define CS_registerInterrupt(...)           STATIC_VECTOR_TABLE_forbids_registerInterrupt
+#define DMA_registerInterrupt(...)          STATIC_VECTOR_TABLE_forbids_registerInterrupt
+#define FlashCtl_registerInterrupt(...)     STATIC_VECTOR_TABLE_forbids_registerInterrupt
+#define GPIO_registerInterrupt(...)         STATIC_VECTOR_TABLE_forbids_registerInterrupt
+#define I2C_registerInterrupt(...)          STATIC_VECTOR_TABLE_forbids_registerInterrupt
+#define PCM_registerInterrupt(...)          STATIC_VECTOR_TABLE_forbids_registerInterrupt
+#define PSS_registerInterrupt(...)          STATIC_VECTOR_TABLE_forbids_registerInterrupt
+#define RTC_C_registerInterrupt(...)        STATIC_VECTOR_TABLE_forbids_registerInterrupt
+#define SPI_registerInterrupt(...)          STATIC_VECTOR_TABLE_forbids_registerInterrupt
+#define SysTick_registerInterrupt(...)      STATIC_VECTOR_TABLE_forbids_registerInterrupt
+#define Timer32_registerInterrupt(...)      STATIC_VECTOR_TABLE_forbids_registerInterrupt
+#define Timer_A_registerInterrupt(...)      STATIC_VECTOR_TABLE_forbids_registerInterrupt
+#define UART_registerInterrupt(...)         STATIC_VECTOR_TABLE_forbids_registerInterrupt
+#define WDT_A_registerInterrupt(...)        STATIC_VECTOR_TABLE_forbids_registerInterrupt
+
+#endif
+
+#endif /* VECTOR_TABLE_H_ */